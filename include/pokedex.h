@@ -0,0 +1,208 @@
+/**
+ * pokedex.h - Public interface of libpokedex
+ * Data loading, search, type, similarity, progress and JSON functions,
+ * usable without the HTTP server. Only what is declared here is exported
+ * from the shared library
+ *
+ * POKEDEX_API_VERSION is the shared library major version and changes
+ * whenever these prototypes or structs change
+ */
+
+#ifndef POKEDEX_H
+#define POKEDEX_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#define POKEDEX_API_VERSION 1
+
+#if defined(_WIN32) && defined(POKEDEX_BUILDING)
+    #define POKEDEX_API __declspec(dllexport)
+#elif defined(__GNUC__)
+    #define POKEDEX_API __attribute__((visibility("default")))
+#else
+    #define POKEDEX_API
+#endif
+
+#define MAX_POKEMON 151
+#define POKEMON_COLUMN_STRIDE 160   // MAX_POKEMON padded to a multiple of 16 for SIMD
+#define MAX_TEAM_SIZE 6
+#define MAX_SIMILAR_RESULTS 50
+#define MAX_GENERATIONS 9
+
+// ============================================================================
+// Data Structures
+// ============================================================================
+
+typedef enum {
+    TYPE_NORMAL, TYPE_FIRE, TYPE_WATER, TYPE_ELECTRIC, TYPE_GRASS, TYPE_ICE,
+    TYPE_FIGHTING, TYPE_POISON, TYPE_GROUND, TYPE_FLYING, TYPE_PSYCHIC, TYPE_BUG,
+    TYPE_ROCK, TYPE_GHOST, TYPE_DRAGON, TYPE_DARK, TYPE_STEEL, TYPE_FAIRY,
+    TYPE_COUNT
+} TypeId;
+
+#define TYPE_NONE 0xFF
+
+typedef enum {
+    STAT_HP, STAT_ATTACK, STAT_DEFENSE, STAT_SP_ATTACK, STAT_SP_DEFENSE, STAT_SPEED,
+    STAT_COUNT
+} StatId;
+
+// Offset of a NUL-terminated string in PokedexData.strings (0 is "")
+typedef unsigned int StrRef;
+
+// Hot record: everything lists, filters and lookups touch, packed densely
+typedef struct {
+    unsigned short id;
+    unsigned char type1_id;         // Interned TypeId
+    unsigned char type2_id;         // TYPE_NONE if single-typed
+    unsigned short hp;
+    unsigned short attack;
+    unsigned short defense;
+    unsigned short sp_attack;
+    unsigned short sp_defense;
+    unsigned short speed;
+    StrRef name;
+} Pokemon;
+
+// Cold record: display text, parallel to pokemon_array
+typedef struct {
+    StrRef ability1;
+    StrRef ability2;
+    StrRef description;
+} PokemonText;
+
+// Library internals; callers only pass them around inside PokedexData
+typedef struct BSTNode BSTNode;
+typedef struct ArenaBlock ArenaBlock;
+
+typedef struct {
+    ArenaBlock* head;
+    size_t block_size;
+} Arena;
+
+typedef struct {
+    Arena arena;                    // Owns every allocation below
+    Pokemon* pokemon_array;
+    PokemonText* text;
+    char* strings;                  // Interned string pool
+    size_t strings_len;
+    BSTNode* name_bst_root;
+    int count;
+    unsigned char type_effect[TYPE_COUNT][POKEMON_COLUMN_STRIDE];  // Attacking type vs species, x0.25
+    unsigned int type_mask[POKEMON_COLUMN_STRIDE];                 // Bit per TypeId of each species
+    short stat_columns[STAT_COUNT][POKEMON_COLUMN_STRIDE];         // Base stats, one column per stat
+} PokedexData;
+
+static inline const char* pokedex_string(const PokedexData* pokedex, StrRef ref) {
+    return pokedex->strings + ref;
+}
+
+typedef struct {
+    int team_ids[MAX_TEAM_SIZE];
+    int team_size;
+    int super_effective;            // Species some member hits super effectively
+    int neutral;
+    int resisted;
+    int immune;
+    int threatened_by[MAX_TEAM_SIZE];   // Species with a type super effective vs each member
+} TeamCoverage;
+
+typedef struct {
+    int id;
+    int distance;                   // Squared Euclidean distance of stat vectors
+} SimilarResult;
+
+typedef struct {
+    int id;
+    bool encountered;
+    bool caught;
+} ProgressEntry;
+
+typedef struct {
+    int total;
+    int seen;
+    int caught;
+} CompletionCounter;
+
+typedef struct {
+    ProgressEntry entries[151];
+    int total_encountered;
+    int total_caught;
+    // Derived aggregates below are rebuilt by progress_bind_pokedex and never persisted
+    unsigned char species_types[MAX_POKEMON][2];
+    unsigned char species_generation[MAX_POKEMON];
+    CompletionCounter by_type[TYPE_COUNT];
+    CompletionCounter by_generation[MAX_GENERATIONS];
+} UserProgress;
+
+// Bytes of UserProgress written to the progress file
+#define PROGRESS_PERSISTED_SIZE offsetof(UserProgress, species_types)
+
+// ============================================================================
+// File I/O Functions (file_io.c)
+// ============================================================================
+
+// Receives the loaders' errors and warnings, one line without a newline.
+// The library prints nothing itself; with no logger set (the default) they are dropped
+typedef void (*PokedexLogger)(const char* message);
+
+POKEDEX_API void pokedex_set_logger(PokedexLogger logger);
+POKEDEX_API int load_pokemon_data(const char* filename, PokedexData* pokedex);
+POKEDEX_API void free_pokemon_data(PokedexData* pokedex);
+POKEDEX_API int load_user_progress(const char* filename, UserProgress* progress);
+POKEDEX_API int save_user_progress(const char* filename, UserProgress* progress);
+POKEDEX_API void initialize_progress(UserProgress* progress);
+
+// ============================================================================
+// Search Functions (search.c)
+// ============================================================================
+
+POKEDEX_API Pokemon* search_by_id(PokedexData* pokedex, int id);
+POKEDEX_API Pokemon* search_by_name(PokedexData* pokedex, const char* name);
+
+// ============================================================================
+// Type Functions (types.c)
+// ============================================================================
+
+POKEDEX_API int type_from_name(const char* name);
+POKEDEX_API const char* type_name(int type_id);
+POKEDEX_API int type_effectiveness(int attacker, int defender1, int defender2);
+POKEDEX_API int score_team(PokedexData* pokedex, const int* ids, int count, TeamCoverage* out);
+
+// ============================================================================
+// Similarity Functions (similar.c)
+// ============================================================================
+
+POKEDEX_API int find_similar(PokedexData* pokedex, int id, int k, unsigned int type_filter,
+                             SimilarResult* results);
+
+// ============================================================================
+// Progress Functions (progress.c)
+// ============================================================================
+
+POKEDEX_API void mark_encountered(UserProgress* progress, int pokemon_id);
+POKEDEX_API void mark_caught(UserProgress* progress, int pokemon_id);
+POKEDEX_API ProgressEntry* get_progress(UserProgress* progress, int pokemon_id);
+POKEDEX_API void reset_pokemon(UserProgress* progress, int pokemon_id);
+POKEDEX_API void reset_all_progress(UserProgress* progress);
+POKEDEX_API void progress_bind_pokedex(UserProgress* progress, PokedexData* pokedex);
+POKEDEX_API int pokemon_generation(int pokemon_id);
+
+// ============================================================================
+// JSON Functions (json.c)
+// ============================================================================
+
+POKEDEX_API void pokemon_to_json(PokedexData* pokedex, Pokemon* p, ProgressEntry* prog,
+                                 char* buffer, size_t size);
+POKEDEX_API void progress_to_json(UserProgress* progress, char* buffer, size_t size);
+POKEDEX_API void completion_to_json(UserProgress* progress, char* buffer, size_t size);
+POKEDEX_API void list_to_json(PokedexData* pokedex, UserProgress* progress,
+                              bool caught_only, bool seen_only, char* buffer, size_t size);
+POKEDEX_API void matchup_to_json(int attacker, int defender1, int defender2,
+                                 char* buffer, size_t size);
+POKEDEX_API void coverage_to_json(TeamCoverage* coverage, char* buffer, size_t size);
+POKEDEX_API void similar_to_json(PokedexData* pokedex, int id, SimilarResult* results, int count,
+                                 char* buffer, size_t size);
+
+#endif
@@ -1,102 +1,285 @@
 /**
  * pokemon.h - Main header file for Pokedex application
  * Contains all struct definitions and function prototypes
+ *
+ * The libpokedex interface lives in pokedex.h; this header adds the
+ * library's internal helpers and everything the server is built from
  */
 
 #ifndef POKEMON_H
 #define POKEMON_H
 
-#include <stdbool.h>
-#include <stddef.h>
+#include "pokedex.h"
+
+#define PROGRESS_FILE "user_progress.dat"
 
 // ============================================================================
-// Data Structures
+// Internal Data Structures
 // ============================================================================
 
-typedef struct {
-    int id;
-    char name[30];
-    char type1[15];
-    char type2[15];
-    int hp;
-    int attack;
-    int defense;
-    int sp_attack;
-    int sp_defense;
-    int speed;
-    char ability1[30];
-    char ability2[30];
-    char description[256];
-} Pokemon;
-
-typedef struct BSTNode {
+struct BSTNode {
+    const char* name;
     Pokemon* pokemon;
     struct BSTNode* left;
     struct BSTNode* right;
-} BSTNode;
+};
+
+struct ArenaBlock {
+    struct ArenaBlock* next;
+    size_t used;
+    size_t cap;
+    _Alignas(16) char data[];
+};
+
+// ============================================================================
+// HTTP Routing Structures
+// ============================================================================
+
+#define MAX_QUERY_PARAMS 16
+// Route table slots: next power of two >= ROUTER_LOAD_FACTOR x route count.
+// At load 1/4 a collision-free seed usually exists for a few dozen paths;
+// past that router_build falls back to linear probing, still O(1) expected
+#define ROUTER_LOAD_FACTOR 4
+#define ROUTER_MIN_SLOTS 16
+
+typedef enum {
+    HTTP_METHOD_UNKNOWN = -1,
+    HTTP_GET = 0,
+    HTTP_POST,
+    HTTP_OPTIONS,
+    HTTP_METHOD_COUNT
+} HttpMethod;
+
+// Key/value slices pointing into the request buffer (not decoded)
+typedef struct {
+    const char* key;
+    size_t key_len;
+    const char* value;
+    size_t value_len;
+} QueryParam;
 
 typedef struct {
-    Pokemon pokemon_array[151];
-    BSTNode* name_bst_root;
+    QueryParam params[MAX_QUERY_PARAMS];
     int count;
-} PokedexData;
+} QueryString;
+
+typedef struct {
+    HttpMethod method;
+    const char* path;
+    size_t path_len;
+    QueryString query;
+} HttpRequest;
+
+// Serialized response, drained to the socket by the event loop
+typedef struct {
+    char* data;
+    size_t len;
+    size_t cap;
+    bool keep_alive;                // Set by the server before dispatch
+} ResponseBuffer;
+
+typedef struct {
+    ResponseBuffer* out;
+    HttpRequest* request;
+    PokedexData* pokedex;
+    UserProgress* progress;
+} RequestContext;
+
+typedef void (*RouteHandler)(RequestContext* ctx);
+
+// Persists progress after a handler changes it; returns 1 on success
+typedef int (*ProgressSaver)(UserProgress* progress);
+
+typedef struct {
+    HttpMethod method;
+    const char* path;
+    RouteHandler handler;
+} Route;
+
+typedef struct {
+    const char* path;
+    size_t path_len;
+    unsigned int allowed;                       // Bitmask of (1 << HttpMethod)
+    RouteHandler handlers[HTTP_METHOD_COUNT];
+} RouteSlot;
+
+typedef struct {
+    RouteSlot* slots;
+    unsigned int mask;                          // Slot count - 1
+    unsigned int seed;
+    bool perfect;                               // Every path sits in its home slot
+} Router;
+
+// ============================================================================
+// Server Structures
+// ============================================================================
+
+#define TIMER_WHEEL_BITS 6
+#define TIMER_WHEEL_SLOTS (1 << TIMER_WHEEL_BITS)
+#define TIMER_WHEEL_LEVELS 4
+#define RATE_LIMIT_BUCKETS 1024     // Must be a power of two
+#define RATE_LIMIT_ENTRIES 4096
+#define RATE_LIMIT_FULL -1          // ratelimit_check: no bucket free, the server is overloaded
+
+// Intrusive timer; embed as the first member of the owning struct
+typedef struct TimerNode {
+    struct TimerNode* prev;
+    struct TimerNode* next;
+    unsigned long long expires_ms;
+} TimerNode;
+
+typedef struct {
+    TimerNode slots[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];    // Sentinel list heads
+    unsigned long long current_tick;
+    unsigned int resolution_ms;
+    int pending;
+} TimerWheel;
+
+typedef struct {
+    TimerNode timer;                // Idle expiry, must stay first
+    unsigned int ip;
+    unsigned int tokens;            // Milli-tokens
+    unsigned long long last_ms;
+    int next;                       // Hash chain / free list index
+} RateLimitEntry;
+
+typedef struct {
+    int heads[RATE_LIMIT_BUCKETS];
+    RateLimitEntry entries[RATE_LIMIT_ENTRIES];
+    int free_head;
+    int active;
+    int rate_per_sec;
+    int burst;
+    TimerWheel expiry;
+} RateLimiter;
 
 typedef struct {
-    int id;
-    bool encountered;
-    bool caught;
-} ProgressEntry;
+    int port;
+    int backlog;                    // listen() queue length
+    int max_connections;            // Open connections before shedding with 503
+    int rate_per_sec;               // Per-IP requests per second, 0 = unlimited
+    int burst;                      // Per-IP bucket size
+    int header_timeout_ms;          // Request line + headers must arrive within this
+    int body_timeout_ms;            // Request body must arrive within this
+    int write_timeout_ms;           // Response must be drained within this
+    int idle_timeout_ms;            // Keep-alive connection may sit idle this long
+    int drain_timeout_ms;           // Connections still open this long into a drain are closed
+    const char* handoff_path;       // Unix socket for listener handoff, NULL = off
+    const char* access_log_path;    // Access log file, "-" = stdout, NULL = off
+    int log_sample;                 // Log every Nth request (5xx always logged)
+    bool io_uring;                  // Prefer io_uring when built with HAVE_IO_URING
+} ServerConfig;
+
+#define ACCESS_LOG_PATH_MAX 96
 
+// One access log line, captured on the request path and formatted later
 typedef struct {
-    ProgressEntry entries[151];
-    int total_encountered;
-    int total_caught;
-} UserProgress;
+    unsigned long long timestamp_ms;    // Wall clock when the response completed
+    unsigned int ip;
+    unsigned int bytes;                 // Response bytes sent
+    unsigned int latency_us;            // First byte received to last byte sent
+    int status;
+    char method[8];
+    char path[ACCESS_LOG_PATH_MAX];     // Request target, truncated
+} AccessLogRecord;
 
 // ============================================================================
-// File I/O Functions (file_io.c)
+// Library Internals (search.c, arena.c, types.c, similar.c)
 // ============================================================================
 
-int load_pokemon_data(const char* filename, PokedexData* pokedex);
-int load_user_progress(const char* filename, UserProgress* progress);
-int save_user_progress(const char* filename, UserProgress* progress);
-void initialize_progress(UserProgress* progress);
+BSTNode* bst_insert(Arena* arena, BSTNode* root, Pokemon* pokemon, const char* name);
+void arena_init(Arena* arena, size_t block_size);
+void* arena_alloc(Arena* arena, size_t size);
+void arena_free(Arena* arena);
+void build_type_index(PokedexData* pokedex);
+void build_stat_index(PokedexData* pokedex);
 
 // ============================================================================
-// Search Functions (search.c)
+// Router Functions (router.c)
 // ============================================================================
 
-Pokemon* search_by_id(PokedexData* pokedex, int id);
-Pokemon* search_by_name(PokedexData* pokedex, const char* name);
-BSTNode* bst_insert(BSTNode* root, Pokemon* pokemon);
-void bst_destroy(BSTNode* root);
+int router_build(Router* router, const Route* routes, int count);
+RouteHandler router_lookup(const Router* router, HttpMethod method,
+                           const char* path, size_t path_len, unsigned int* allowed);
+int parse_request_line(const char* request, HttpRequest* out);
+const QueryParam* query_get(const QueryString* query, const char* key);
+int query_decode(const QueryParam* param, char* buffer, size_t size);
+int query_get_int(const QueryString* query, const char* key, int* value);
+const char* find_header(const char* headers, size_t len, const char* name, size_t* value_len);
+
+// ============================================================================
+// Timer Wheel Functions (timer_wheel.c)
+// ============================================================================
+
+void timer_wheel_init(TimerWheel* wheel, unsigned long long now_ms, unsigned int resolution_ms);
+void timer_schedule(TimerWheel* wheel, TimerNode* node, unsigned long long expires_ms);
+void timer_cancel(TimerWheel* wheel, TimerNode* node);
+int timer_wheel_advance(TimerWheel* wheel, unsigned long long now_ms,
+                        void (*on_expire)(TimerNode* node, void* ctx), void* ctx);
+
+// ============================================================================
+// Rate Limiting Functions (ratelimit.c)
+// ============================================================================
+
+void ratelimit_init(RateLimiter* limiter, int rate_per_sec, int burst, unsigned long long now_ms);
+int ratelimit_check(RateLimiter* limiter, unsigned int ip, unsigned long long now_ms);
+
+// ============================================================================
+// Access Log Functions (access_log.c)
+// ============================================================================
+
+int access_log_start(const char* path, int sample);
+void access_log_submit(const AccessLogRecord* record);
+unsigned long long access_log_dropped(void);
+void access_log_stop(void);
+
+// ============================================================================
+// io_uring Functions (uring.c, Linux builds with HAVE_IO_URING only)
+// ============================================================================
+
+#ifdef HAVE_IO_URING
+typedef struct IoRing IoRing;
+struct io_uring_sqe;
+struct io_uring_cqe;
+struct iovec;
+
+IoRing* uring_create(unsigned entries);
+void uring_destroy(IoRing* ring);
+struct io_uring_sqe* uring_get_sqe(IoRing* ring);
+int uring_submit(IoRing* ring, unsigned wait_nr);
+struct io_uring_cqe* uring_peek_cqe(IoRing* ring);
+void uring_cqe_seen(IoRing* ring);
+int uring_register_buffers(IoRing* ring, const struct iovec* buffers, unsigned count);
+int uring_register_files(IoRing* ring, const int* fds, unsigned count);
+#endif
 
 // ============================================================================
-// Progress Functions (progress.c)
+// Event Loop Functions (server.c)
 // ============================================================================
 
-void mark_encountered(UserProgress* progress, int pokemon_id);
-void mark_caught(UserProgress* progress, int pokemon_id);
-ProgressEntry* get_progress(UserProgress* progress, int pokemon_id);
-void reset_pokemon(UserProgress* progress, int pokemon_id);
-void reset_all_progress(UserProgress* progress);
+int open_listener(const ServerConfig* config);
+int run_server(const ServerConfig* config, int server_sock,
+               PokedexData* pokedex, UserProgress* progress);
 
 // ============================================================================
-// JSON Functions (json.c)
+// Handoff Functions (handoff.c)
 // ============================================================================
 
-void pokemon_to_json(Pokemon* p, ProgressEntry* prog, char* buffer, size_t size);
-void progress_to_json(UserProgress* progress, char* buffer, size_t size);
-void list_to_json(PokedexData* pokedex, UserProgress* progress, 
-                  bool caught_only, bool seen_only, char* buffer, size_t size);
+int handoff_listen(const char* path);
+int handoff_send(int peer, int listen_fd);
+int handoff_receive(const char* path);
 
 // ============================================================================
 // Server Functions (http_server.c)
 // ============================================================================
 
-void send_response(int client_sock, int status_code, const char* content_type, 
+int init_routes(void);
+void set_progress_saver(ProgressSaver saver);
+void send_response(ResponseBuffer* out, int status_code, const char* content_type, 
                    const char* body, size_t body_len);
-void handle_request(int client_sock, const char* request,
+void send_response_headers(ResponseBuffer* out, int status_code, const char* content_type,
+                           const char* extra_headers, const char* body, size_t body_len);
+void handle_request(ResponseBuffer* out, const char* request,
                     PokedexData* pokedex, UserProgress* progress);
 
 #endif
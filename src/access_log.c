@@ -0,0 +1,206 @@
+/**
+ * access_log.c - Asynchronous access log
+ * Request threads push fixed-size records into their own single-producer
+ * ring; a background thread formats and writes them in batches. A full
+ * ring drops the record and counts it, so logging never blocks a request
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <time.h>
+#include "../include/pokemon.h"
+
+#define RING_SIZE 4096              // Records per thread, power of two
+#define MAX_LOG_THREADS 16
+#define DRAIN_INTERVAL_MS 20
+#define WRITE_BATCH_SIZE 65536
+
+typedef struct {
+    AccessLogRecord records[RING_SIZE];
+    _Atomic size_t head;            // Next slot the producer fills
+    _Atomic size_t tail;            // Next slot the drain thread reads
+    unsigned int sample_counter;
+} AccessLogRing;
+
+static _Atomic(AccessLogRing*) rings[MAX_LOG_THREADS];
+static atomic_int ring_count;
+static _Thread_local AccessLogRing* thread_ring;
+
+static atomic_ullong dropped;
+static atomic_bool running;
+static pthread_t drain_thread;
+static int log_fd = -1;
+static int sample_rate = 1;
+
+/**
+ * Claim this thread's ring on its first record
+ */
+static AccessLogRing* get_thread_ring(void) {
+    if (thread_ring) return thread_ring;
+
+    int index = atomic_fetch_add(&ring_count, 1);
+    if (index >= MAX_LOG_THREADS) return NULL;
+
+    AccessLogRing* ring = calloc(1, sizeof(AccessLogRing));
+    if (!ring) return NULL;
+
+    atomic_store_explicit(&rings[index], ring, memory_order_release);
+    thread_ring = ring;
+    return ring;
+}
+
+static void write_all(const char* data, size_t len) {
+    while (len > 0) {
+        ssize_t written = write(log_fd, data, len);
+        if (written < 0 && errno == EINTR) continue;
+        if (written <= 0) return;
+        data += written;
+        len -= (size_t)written;
+    }
+}
+
+static size_t format_record(const AccessLogRecord* record, char* out, size_t size) {
+    int len = snprintf(out, size,
+        "ts=%llu ip=%u.%u.%u.%u method=%s path=%s status=%d bytes=%u latency_us=%u\n",
+        record->timestamp_ms,
+        (record->ip >> 24) & 0xFF, (record->ip >> 16) & 0xFF,
+        (record->ip >> 8) & 0xFF, record->ip & 0xFF,
+        record->method, record->path, record->status, record->bytes, record->latency_us);
+    return len > 0 && (size_t)len < size ? (size_t)len : 0;
+}
+
+/**
+ * Move everything currently queued to the log. Returns records written
+ */
+static int drain_rings(char* batch) {
+    size_t batch_len = 0;
+    int drained = 0;
+
+    int count = atomic_load(&ring_count);
+    if (count > MAX_LOG_THREADS) count = MAX_LOG_THREADS;
+
+    for (int i = 0; i < count; i++) {
+        AccessLogRing* ring = atomic_load_explicit(&rings[i], memory_order_acquire);
+        if (!ring) continue;
+
+        size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+        size_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+        for (; tail != head; tail++) {
+            if (WRITE_BATCH_SIZE - batch_len < 512) {
+                write_all(batch, batch_len);
+                batch_len = 0;
+            }
+            batch_len += format_record(&ring->records[tail & (RING_SIZE - 1)],
+                                       batch + batch_len, WRITE_BATCH_SIZE - batch_len);
+            drained++;
+        }
+        atomic_store_explicit(&ring->tail, tail, memory_order_release);
+    }
+
+    if (batch_len > 0) write_all(batch, batch_len);
+    return drained;
+}
+
+static void* drain_main(void* arg) {
+    (void)arg;
+    char* batch = malloc(WRITE_BATCH_SIZE);
+    if (!batch) return NULL;
+
+    unsigned long long reported = 0;
+    while (1) {
+        bool stopping = !atomic_load(&running);
+        int drained = drain_rings(batch);
+
+        unsigned long long total = atomic_load(&dropped);
+        if (total != reported) {
+            int len = snprintf(batch, WRITE_BATCH_SIZE, "access_log dropped=%llu total_dropped=%llu\n",
+                               total - reported, total);
+            write_all(batch, (size_t)len);
+            reported = total;
+        }
+
+        if (stopping) break;
+        if (drained == 0) {
+            struct timespec pause = { 0, DRAIN_INTERVAL_MS * 1000000L };
+            nanosleep(&pause, NULL);
+        }
+    }
+
+    free(batch);
+    return NULL;
+}
+
+/**
+ * Start the drain thread writing to path ("-" or NULL = stdout).
+ * Every sample-th request is logged; 5xx responses always are
+ * Returns 1 on success, 0 on failure
+ */
+int access_log_start(const char* path, int sample) {
+    if (!path || strcmp(path, "-") == 0) {
+        log_fd = STDOUT_FILENO;
+    } else {
+        log_fd = open(path, O_WRONLY | O_CREAT | O_APPEND, 0644);
+        if (log_fd < 0) return 0;
+    }
+
+    sample_rate = sample > 0 ? sample : 1;
+    atomic_store(&running, true);
+    if (pthread_create(&drain_thread, NULL, drain_main, NULL) != 0) {
+        atomic_store(&running, false);
+        if (log_fd != STDOUT_FILENO) close(log_fd);
+        log_fd = -1;
+        return 0;
+    }
+    return 1;
+}
+
+/**
+ * Queue a record for the drain thread. Never blocks: when this thread's
+ * ring is full the record is dropped and counted
+ */
+void access_log_submit(const AccessLogRecord* record) {
+    if (log_fd < 0) return;
+
+    AccessLogRing* ring = get_thread_ring();
+    if (!ring) {
+        atomic_fetch_add_explicit(&dropped, 1, memory_order_relaxed);
+        return;
+    }
+
+    if (record->status < 500 && ring->sample_counter++ % (unsigned int)sample_rate != 0) return;
+
+    size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    if (head - tail == RING_SIZE) {
+        atomic_fetch_add_explicit(&dropped, 1, memory_order_relaxed);
+        return;
+    }
+
+    ring->records[head & (RING_SIZE - 1)] = *record;
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+}
+
+/**
+ * Records dropped so far because a ring was full
+ */
+unsigned long long access_log_dropped(void) {
+    return atomic_load(&dropped);
+}
+
+/**
+ * Flush everything queued and stop the drain thread
+ */
+void access_log_stop(void) {
+    if (log_fd < 0) return;
+
+    atomic_store(&running, false);
+    pthread_join(drain_thread, NULL);
+    if (log_fd != STDOUT_FILENO) close(log_fd);
+    log_fd = -1;
+}
@@ -0,0 +1,54 @@
+/**
+ * arena.c - Bump allocator for load-time data
+ * Everything allocated from an arena is released together by arena_free
+ */
+
+#include <stdlib.h>
+#include "../include/pokemon.h"
+
+#define ARENA_ALIGN 16
+
+/**
+ * Initialize an empty arena. The first block is allocated on demand
+ */
+void arena_init(Arena* arena, size_t block_size) {
+    arena->head = NULL;
+    arena->block_size = block_size > 0 ? block_size : 65536;
+}
+
+/**
+ * Allocate size bytes aligned to ARENA_ALIGN. Requests that do not fit
+ * the current block start a new one. Returns NULL on allocation failure
+ */
+void* arena_alloc(Arena* arena, size_t size) {
+    size = (size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+
+    ArenaBlock* block = arena->head;
+    if (block == NULL || block->cap - block->used < size) {
+        size_t cap = size > arena->block_size ? size : arena->block_size;
+        block = malloc(sizeof(ArenaBlock) + cap);
+        if (!block) return NULL;
+
+        block->next = arena->head;
+        block->used = 0;
+        block->cap = cap;
+        arena->head = block;
+    }
+
+    void* ptr = block->data + block->used;
+    block->used += size;
+    return ptr;
+}
+
+/**
+ * Release every block of the arena at once
+ */
+void arena_free(Arena* arena) {
+    ArenaBlock* block = arena->head;
+    while (block) {
+        ArenaBlock* next = block->next;
+        free(block);
+        block = next;
+    }
+    arena->head = NULL;
+}
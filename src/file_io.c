@@ -5,12 +5,40 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdarg.h>
 #include <string.h>
 #include <ctype.h>
 #include "../include/pokemon.h"
 
-// Forward declaration for BST insert
-extern BSTNode* bst_insert(BSTNode* root, Pokemon* pokemon);
+#define INTERN_SLOTS 2048     // Power of two, comfortably above the distinct strings in the CSV
+
+// Load-time string interner; the pool and slots live in the pokedex arena
+typedef struct {
+    char* pool;
+    size_t len;
+    size_t cap;
+    StrRef* slots;              // Open addressing, 0 = empty
+} StringInterner;
+
+static PokedexLogger logger;
+
+/**
+ * Route loader diagnostics to the caller's logger (NULL = silent)
+ */
+void pokedex_set_logger(PokedexLogger fn) {
+    logger = fn;
+}
+
+static void log_message(const char* format, ...) {
+    if (!logger) return;
+
+    char message[256];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(message, sizeof(message), format, args);
+    va_end(args);
+    logger(message);
+}
 
 /**
  * Parse next CSV field, handling quotes and empty fields
@@ -76,100 +104,180 @@ static char* parse_csv_field(char* input, char* output, size_t max_len) {
     return p;
 }
 
+/**
+ * Return the pool offset of str, appending it on first sight.
+ * Identical strings (repeated abilities, mostly) share one copy
+ */
+static StrRef intern_string(StringInterner* interner, const char* str) {
+    if (str[0] == '\0') return 0;
+    
+    unsigned int hash = 2166136261u;
+    for (const char* c = str; *c; c++) {
+        hash ^= (unsigned char)*c;
+        hash *= 16777619u;
+    }
+    
+    size_t slot = hash & (INTERN_SLOTS - 1);
+    while (interner->slots[slot] != 0) {
+        if (strcmp(interner->pool + interner->slots[slot], str) == 0) {
+            return interner->slots[slot];
+        }
+        slot = (slot + 1) & (INTERN_SLOTS - 1);
+    }
+    
+    size_t len = strlen(str) + 1;
+    if (interner->len + len > interner->cap) {
+        log_message("Warning: string pool full, dropping \"%s\"", str);
+        return 0;
+    }
+    
+    StrRef ref = (StrRef)interner->len;
+    memcpy(interner->pool + interner->len, str, len);
+    interner->len += len;
+    interner->slots[slot] = ref;
+    return ref;
+}
+
 /**
  * Load Pokemon data from CSV file
+ * All memory comes from pokedex->arena; release it with free_pokemon_data
  * Returns number of Pokemon loaded, or 0 on failure
  */
 int load_pokemon_data(const char* filename, PokedexData* pokedex) {
-    printf("Attempting to open: %s\n", filename);
-    fflush(stdout);
-    
     FILE* file = fopen(filename, "r");
     if (!file) {
-        printf("Error: Could not open %s\n", filename);
-        fflush(stdout);
+        log_message("Error: Could not open %s", filename);
         return 0;
     }
-    printf("File opened successfully\n");
-    fflush(stdout);
     
     char line[1024];
     if (!fgets(line, sizeof(line), file)) {
-        printf("Error: Could not read header line\n");
-        fflush(stdout);
+        log_message("Error: Could not read header line");
+        fclose(file);
+        return 0;
+    }
+    
+    // The text in the file bounds the size of the string pool
+    fseek(file, 0, SEEK_END);
+    size_t file_size = (size_t)ftell(file);
+    fseek(file, (long)strlen(line), SEEK_SET);
+    
+    StringInterner interner;
+    interner.cap = file_size + 1;
+    interner.len = 1;           // Offset 0 is the empty string
+    
+    arena_init(&pokedex->arena, file_size + 65536);
+    pokedex->pokemon_array = arena_alloc(&pokedex->arena, sizeof(Pokemon) * MAX_POKEMON);
+    pokedex->text = arena_alloc(&pokedex->arena, sizeof(PokemonText) * MAX_POKEMON);
+    interner.pool = arena_alloc(&pokedex->arena, interner.cap);
+    interner.slots = arena_alloc(&pokedex->arena, sizeof(StrRef) * INTERN_SLOTS);
+    if (!pokedex->pokemon_array || !pokedex->text || !interner.pool || !interner.slots) {
+        log_message("Error: Out of memory");
         fclose(file);
+        arena_free(&pokedex->arena);
         return 0;
     }
+    interner.pool[0] = '\0';
+    memset(interner.slots, 0, sizeof(StrRef) * INTERN_SLOTS);
     
+    pokedex->strings = interner.pool;
     pokedex->count = 0;
     pokedex->name_bst_root = NULL;
     
-    while (fgets(line, sizeof(line), file) && pokedex->count < 151) {
+    while (fgets(line, sizeof(line), file) && pokedex->count < MAX_POKEMON) {
         Pokemon* p = &pokedex->pokemon_array[pokedex->count];
+        PokemonText* text = &pokedex->text[pokedex->count];
         char field[256];
+        char type1[16], type2[16];
         char* ptr = line;
         
         // id
         ptr = parse_csv_field(ptr, field, sizeof(field));
-        p->id = atoi(field);
+        p->id = (unsigned short)atoi(field);
         if (p->id == 0) continue;  // Skip invalid lines
         
         // name
-        ptr = parse_csv_field(ptr, p->name, sizeof(p->name));
+        ptr = parse_csv_field(ptr, field, sizeof(field));
+        p->name = intern_string(&interner, field);
         
         // type1
-        ptr = parse_csv_field(ptr, p->type1, sizeof(p->type1));
+        ptr = parse_csv_field(ptr, type1, sizeof(type1));
         
         // type2 (can be empty)
-        ptr = parse_csv_field(ptr, p->type2, sizeof(p->type2));
+        ptr = parse_csv_field(ptr, type2, sizeof(type2));
         
         // hp
         ptr = parse_csv_field(ptr, field, sizeof(field));
-        p->hp = atoi(field);
+        p->hp = (unsigned short)atoi(field);
         
         // attack
         ptr = parse_csv_field(ptr, field, sizeof(field));
-        p->attack = atoi(field);
+        p->attack = (unsigned short)atoi(field);
         
         // defense
         ptr = parse_csv_field(ptr, field, sizeof(field));
-        p->defense = atoi(field);
+        p->defense = (unsigned short)atoi(field);
         
         // sp_attack
         ptr = parse_csv_field(ptr, field, sizeof(field));
-        p->sp_attack = atoi(field);
+        p->sp_attack = (unsigned short)atoi(field);
         
         // sp_defense
         ptr = parse_csv_field(ptr, field, sizeof(field));
-        p->sp_defense = atoi(field);
+        p->sp_defense = (unsigned short)atoi(field);
         
         // speed
         ptr = parse_csv_field(ptr, field, sizeof(field));
-        p->speed = atoi(field);
+        p->speed = (unsigned short)atoi(field);
         
         // ability1
-        ptr = parse_csv_field(ptr, p->ability1, sizeof(p->ability1));
+        ptr = parse_csv_field(ptr, field, sizeof(field));
+        text->ability1 = intern_string(&interner, field);
         
         // ability2 (can be empty)
-        ptr = parse_csv_field(ptr, p->ability2, sizeof(p->ability2));
+        ptr = parse_csv_field(ptr, field, sizeof(field));
+        text->ability2 = intern_string(&interner, field);
         
         // description (rest of line)
         if (ptr) {
-            parse_csv_field(ptr, p->description, sizeof(p->description));
+            parse_csv_field(ptr, field, sizeof(field));
+            text->description = intern_string(&interner, field);
         } else {
-            p->description[0] = '\0';
+            text->description = 0;
         }
         
-        pokedex->name_bst_root = bst_insert(pokedex->name_bst_root, p);
+        p->type1_id = (unsigned char)type_from_name(type1);
+        p->type2_id = (unsigned char)type_from_name(type2);
+        if (p->type1_id == TYPE_NONE) {
+            log_message("Warning: unknown type '%s' for #%d", type1, p->id);
+            p->type1_id = TYPE_NORMAL;
+        }
+        
+        pokedex->name_bst_root = bst_insert(&pokedex->arena, pokedex->name_bst_root, p,
+                                            pokedex_string(pokedex, p->name));
         pokedex->count++;
     }
     
     fclose(file);
-    printf("Loaded %d Pokemon\n", pokedex->count);
-    fflush(stdout);
+    pokedex->strings_len = interner.len;
+    build_type_index(pokedex);
+    build_stat_index(pokedex);
+    log_message("Loaded %d Pokemon", pokedex->count);
     return pokedex->count > 0 ? pokedex->count : 1;
 }
 
+/**
+ * Release everything load_pokemon_data allocated
+ */
+void free_pokemon_data(PokedexData* pokedex) {
+    arena_free(&pokedex->arena);
+    pokedex->pokemon_array = NULL;
+    pokedex->text = NULL;
+    pokedex->strings = NULL;
+    pokedex->name_bst_root = NULL;
+    pokedex->count = 0;
+}
+
 /**
  * Initialize user progress to default values
  */
@@ -194,7 +302,7 @@ int load_user_progress(const char* filename, UserProgress* progress) {
         return 1;
     }
     
-    size_t read = fread(progress, sizeof(UserProgress), 1, file);
+    size_t read = fread(progress, PROGRESS_PERSISTED_SIZE, 1, file);
     fclose(file);
     
     if (read != 1) {
@@ -215,7 +323,7 @@ int save_user_progress(const char* filename, UserProgress* progress) {
         return 0;
     }
     
-    size_t written = fwrite(progress, sizeof(UserProgress), 1, file);
+    size_t written = fwrite(progress, PROGRESS_PERSISTED_SIZE, 1, file);
     fclose(file);
     
     return (written == 1);
@@ -0,0 +1,128 @@
+/**
+ * handoff.c - Listening socket handoff between server processes
+ * A running server passes its listening socket to its replacement over a
+ * Unix domain socket (SCM_RIGHTS), so the port is never unbound
+ */
+
+#include <string.h>
+#include "../include/pokemon.h"
+
+#ifndef _WIN32
+    #include <sys/socket.h>
+    #include <sys/un.h>
+    #include <unistd.h>
+    #include <fcntl.h>
+#endif
+
+#ifndef _WIN32
+
+static int fill_address(struct sockaddr_un* addr, const char* path) {
+    if (strlen(path) >= sizeof(addr->sun_path)) return 0;
+    memset(addr, 0, sizeof(*addr));
+    addr->sun_family = AF_UNIX;
+    strcpy(addr->sun_path, path);
+    return 1;
+}
+
+/**
+ * Create the Unix socket a future replacement connects to
+ * Returns the socket, or -1 on failure
+ */
+int handoff_listen(const char* path) {
+    struct sockaddr_un addr;
+    if (!fill_address(&addr, path)) return -1;
+
+    int sock = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (sock < 0) return -1;
+
+    unlink(path);
+    if (bind(sock, (struct sockaddr*)&addr, sizeof(addr)) < 0 || listen(sock, 1) < 0) {
+        close(sock);
+        return -1;
+    }
+
+    fcntl(sock, F_SETFL, fcntl(sock, F_GETFL, 0) | O_NONBLOCK);
+    return sock;
+}
+
+/**
+ * Pass listen_fd to a connected replacement process. Keep peer open until
+ * progress is flushed; closing it releases the replacement
+ * Returns 1 on success, 0 on failure
+ */
+int handoff_send(int peer, int listen_fd) {
+    char data = 'L';
+    struct iovec iov = { &data, 1 };
+
+    char control[CMSG_SPACE(sizeof(int))];
+    memset(control, 0, sizeof(control));
+
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+    memcpy(CMSG_DATA(cmsg), &listen_fd, sizeof(int));
+
+    return sendmsg(peer, &msg, 0) == 1;
+}
+
+/**
+ * Ask the server listening on path for its listening socket. The socket
+ * arrives at once; this then blocks until the old server has drained and
+ * flushed its progress, signalled by it closing the connection
+ * Returns the inherited socket, or -1 on failure
+ */
+int handoff_receive(const char* path) {
+    struct sockaddr_un addr;
+    if (!fill_address(&addr, path)) return -1;
+
+    int sock = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (sock < 0) return -1;
+
+    if (connect(sock, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        close(sock);
+        return -1;
+    }
+
+    char data;
+    struct iovec iov = { &data, 1 };
+    char control[CMSG_SPACE(sizeof(int))];
+
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    int fd = -1;
+    if (recvmsg(sock, &msg, 0) == 1) {
+        struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+        if (cmsg && cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS) {
+            memcpy(&fd, CMSG_DATA(cmsg), sizeof(int));
+        }
+    }
+
+    if (fd >= 0) {
+        while (read(sock, &data, 1) > 0) { }
+    }
+
+    close(sock);
+    return fd;
+}
+
+#else
+
+// Descriptor passing is not available on Windows
+int handoff_listen(const char* path) { (void)path; return -1; }
+int handoff_send(int peer, int listen_fd) { (void)peer; (void)listen_fd; return 0; }
+int handoff_receive(const char* path) { (void)path; return -1; }
+
+#endif
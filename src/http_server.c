@@ -8,167 +8,394 @@
 #include <string.h>
 #include "../include/pokemon.h"
 
-#ifdef _WIN32
-    #include <winsock2.h>
-    #include <ws2tcpip.h>
-#else
-    #include <sys/socket.h>
-    #include <netinet/in.h>
-    #include <arpa/inet.h>
-    #include <unistd.h>
-#endif
-
 #define BUFFER_SIZE 65536
 
+// Route table, compiled by init_routes()
+static Router router;
+
+static int save_progress_file(UserProgress* progress) {
+    return save_user_progress(PROGRESS_FILE, progress);
+}
+
+// How mutating handlers persist; the event loop may install an async writer
+static ProgressSaver progress_saver = save_progress_file;
+
 /**
- * Send HTTP response to client
+ * Reason phrase for the status codes this server emits
  */
-void send_response(int client_sock, int status_code, const char* content_type, 
-                   const char* body, size_t body_len) {
+static const char* status_text(int status_code) {
+    switch (status_code) {
+        case 200: return "OK";
+        case 400: return "Bad Request";
+        case 404: return "Not Found";
+        case 405: return "Method Not Allowed";
+        case 500: return "Internal Server Error";
+        default:  return "OK";
+    }
+}
+
+/**
+ * Append bytes to a response buffer, growing it as needed
+ * Returns 1 on success, 0 on allocation failure
+ */
+static int response_append(ResponseBuffer* out, const char* data, size_t len) {
+    if (out->len + len > out->cap) {
+        size_t cap = out->cap ? out->cap : 4096;
+        while (cap < out->len + len) cap *= 2;
+        
+        char* grown = realloc(out->data, cap);
+        if (!grown) return 0;
+        out->data = grown;
+        out->cap = cap;
+    }
+    
+    memcpy(out->data + out->len, data, len);
+    out->len += len;
+    return 1;
+}
+
+/**
+ * Queue HTTP response with optional extra header lines (each ending in \r\n)
+ */
+void send_response_headers(ResponseBuffer* out, int status_code, const char* content_type,
+                           const char* extra_headers, const char* body, size_t body_len) {
     char header[512];
-    snprintf(header, sizeof(header),
-        "HTTP/1.1 %d OK\r\n"
+    int header_len = snprintf(header, sizeof(header),
+        "HTTP/1.1 %d %s\r\n"
         "Content-Type: %s\r\n"
         "Content-Length: %zu\r\n"
+        "Connection: %s\r\n"
         "Access-Control-Allow-Origin: *\r\n"
         "Access-Control-Allow-Methods: GET, POST, OPTIONS\r\n"
         "Access-Control-Allow-Headers: Content-Type\r\n"
+        "%s"
         "\r\n",
-        status_code, content_type, body_len
+        status_code, status_text(status_code), content_type, body_len,
+        out->keep_alive ? "keep-alive" : "close",
+        extra_headers ? extra_headers : ""
     );
     
-    send(client_sock, header, (int)strlen(header), 0);
+    response_append(out, header, (size_t)header_len);
     if (body && body_len > 0) {
-        send(client_sock, body, (int)body_len, 0);
+        response_append(out, body, body_len);
     }
 }
 
 /**
- * Handle incoming HTTP request
+ * Queue HTTP response for the client
  */
-void handle_request(int client_sock, const char* request,
-                    PokedexData* pokedex, UserProgress* progress) {
-    char method[16], path[256];
-    sscanf(request, "%s %s", method, path);
+void send_response(ResponseBuffer* out, int status_code, const char* content_type, 
+                   const char* body, size_t body_len) {
+    send_response_headers(out, status_code, content_type, NULL, body, body_len);
+}
+
+static void send_json(RequestContext* ctx, int status_code, const char* json) {
+    send_response(ctx->out, status_code, "application/json", json, strlen(json));
+}
+
+/**
+ * Read the required "id" parameter, replying 400 if it is missing
+ */
+static bool require_id(RequestContext* ctx, int* id) {
+    if (query_get_int(&ctx->request->query, "id", id)) {
+        return true;
+    }
+    send_json(ctx, 400, "{\"error\":\"Missing id\"}");
+    return false;
+}
+
+// GET /api/progress
+static void handle_progress(RequestContext* ctx) {
+    char response[BUFFER_SIZE];
+    progress_to_json(ctx->progress, response, sizeof(response));
+    send_json(ctx, 200, response);
+}
+
+// GET /api/stats/completion
+static void handle_completion(RequestContext* ctx) {
+    char response[4096];
+    completion_to_json(ctx->progress, response, sizeof(response));
+    send_json(ctx, 200, response);
+}
+
+// GET /api/list?filter=all|caught|seen
+static void handle_list(RequestContext* ctx) {
+    bool caught_only = false;
+    bool seen_only = false;
     
-    printf("Request: %s %s\n", method, path);
+    const QueryParam* filter = query_get(&ctx->request->query, "filter");
+    if (filter) {
+        char value[16];
+        if (query_decode(filter, value, sizeof(value)) < 0) value[0] = '\0';
+        caught_only = strcmp(value, "caught") == 0;
+        seen_only = strcmp(value, "seen") == 0;
+    }
     
-    // Handle OPTIONS for CORS
-    if (strcmp(method, "OPTIONS") == 0) {
-        send_response(client_sock, 200, "text/plain", "", 0);
+    char response[BUFFER_SIZE];
+    list_to_json(ctx->pokedex, ctx->progress, caught_only, seen_only,
+                 response, sizeof(response));
+    send_json(ctx, 200, response);
+}
+
+// GET /api/search?q=name or /api/search?id=25
+static void handle_search(RequestContext* ctx) {
+    Pokemon* p = NULL;
+    
+    int id;
+    const QueryParam* query = query_get(&ctx->request->query, "q");
+    
+    if (query_get_int(&ctx->request->query, "id", &id)) {
+        p = search_by_id(ctx->pokedex, id);
+    } else if (query) {
+        char name[30];
+        if (query_decode(query, name, sizeof(name)) > 0) {
+            p = search_by_name(ctx->pokedex, name);
+        }
+    }
+    
+    if (p) {
+        char response[BUFFER_SIZE];
+        ProgressEntry* prog = get_progress(ctx->progress, p->id);
+        pokemon_to_json(ctx->pokedex, p, prog, response, sizeof(response));
+        send_json(ctx, 200, response);
+    } else {
+        send_json(ctx, 404, "{\"error\":\"Pokemon not found\"}");
+    }
+}
+
+/**
+ * Decode a type-name parameter. Returns TYPE_NONE if missing or unknown
+ */
+static int param_type(const QueryParam* param) {
+    char name[16];
+    if (!param || query_decode(param, name, sizeof(name)) <= 0) return TYPE_NONE;
+    return type_from_name(name);
+}
+
+// GET /api/matchup?attacker=fire&defender=grass,poison
+static void handle_matchup(RequestContext* ctx) {
+    int attacker = param_type(query_get(&ctx->request->query, "attacker"));
+    const QueryParam* defender = query_get(&ctx->request->query, "defender");
+    
+    char names[40];
+    int defender1 = TYPE_NONE, defender2 = TYPE_NONE;
+    if (defender && query_decode(defender, names, sizeof(names)) > 0) {
+        char* second = strchr(names, ',');
+        if (second) *second++ = '\0';
+        defender1 = type_from_name(names);
+        if (second) defender2 = type_from_name(second);
+        if (second && defender2 == TYPE_NONE) defender1 = TYPE_NONE;
+    }
+    
+    if (attacker == TYPE_NONE || defender1 == TYPE_NONE) {
+        send_json(ctx, 400, "{\"error\":\"Unknown or missing type\"}");
         return;
     }
     
-    char response[BUFFER_SIZE];
+    char response[256];
+    matchup_to_json(attacker, defender1, defender2, response, sizeof(response));
+    send_json(ctx, 200, response);
+}
+
+// GET /api/coverage?team=1,6,25
+static void handle_coverage(RequestContext* ctx) {
+    const QueryParam* team = query_get(&ctx->request->query, "team");
     
-    // GET /api/progress
-    if (strcmp(path, "/api/progress") == 0) {
-        progress_to_json(progress, response, sizeof(response));
-        send_response(client_sock, 200, "application/json", response, strlen(response));
+    char list[64];
+    int ids[MAX_TEAM_SIZE];
+    int count = 0;
+    bool valid = team && query_decode(team, list, sizeof(list)) > 0;
+    
+    for (char* p = list; valid && *p; ) {
+        char* end;
+        long id = strtol(p, &end, 10);
+        if (end == p || count == MAX_TEAM_SIZE || (*end != ',' && *end != '\0')) {
+            valid = false;
+            break;
+        }
+        ids[count++] = (int)id;
+        p = *end ? end + 1 : end;
     }
-    // GET /api/list?filter=all|caught|seen
-    else if (strncmp(path, "/api/list", 9) == 0) {
-        bool caught_only = strstr(path, "caught") != NULL;
-        bool seen_only = strstr(path, "seen") != NULL;
-        
-        list_to_json(pokedex, progress, caught_only, seen_only, 
-                     response, sizeof(response));
-        send_response(client_sock, 200, "application/json", response, strlen(response));
+    
+    TeamCoverage coverage;
+    if (!valid || count == 0 || !score_team(ctx->pokedex, ids, count, &coverage)) {
+        send_json(ctx, 400, "{\"error\":\"team must be 1-6 comma-separated Pokemon ids\"}");
+        return;
     }
-    // GET /api/search?q=name or /api/search?id=25
-    else if (strncmp(path, "/api/search", 11) == 0) {
-        Pokemon* p = NULL;
-        
-        char* query = strstr(path, "q=");
-        char* id_param = strstr(path, "id=");
-        
-        if (id_param) {
-            int id = atoi(id_param + 3);
-            p = search_by_id(pokedex, id);
-        } else if (query) {
-            char name[30];
-            sscanf(query + 2, "%29[^&]", name);
-            // URL decode (replace %20 with space)
-            for (int i = 0; name[i]; i++) {
-                if (name[i] == '+') name[i] = ' ';
+    
+    char response[1024];
+    coverage_to_json(&coverage, response, sizeof(response));
+    send_json(ctx, 200, response);
+}
+
+// GET /api/similar?id=25&k=10&type=electric,fire
+static void handle_similar(RequestContext* ctx) {
+    int id;
+    if (!require_id(ctx, &id)) return;
+    
+    int k = 10;
+    query_get_int(&ctx->request->query, "k", &k);
+    
+    unsigned int type_filter = 0;
+    const QueryParam* types = query_get(&ctx->request->query, "type");
+    if (types) {
+        char names[64];
+        if (query_decode(types, names, sizeof(names)) < 0) names[0] = '\0';
+        for (char* name = strtok(names, ","); name; name = strtok(NULL, ",")) {
+            int type_id = type_from_name(name);
+            if (type_id == TYPE_NONE) {
+                send_json(ctx, 400, "{\"error\":\"Unknown type\"}");
+                return;
             }
-            p = search_by_name(pokedex, name);
-        }
-        
-        if (p) {
-            ProgressEntry* prog = get_progress(progress, p->id);
-            pokemon_to_json(p, prog, response, sizeof(response));
-            send_response(client_sock, 200, "application/json", response, strlen(response));
-        } else {
-            send_response(client_sock, 404, "application/json", 
-                         "{\"error\":\"Pokemon not found\"}", 28);
+            type_filter |= 1u << type_id;
         }
     }
-    // POST /api/encounter?id=25
-    else if (strncmp(path, "/api/encounter", 14) == 0) {
-        char* id_param = strstr(path, "id=");
-        if (id_param) {
-            int id = atoi(id_param + 3);
-            mark_encountered(progress, id);
-            save_user_progress("user_progress.dat", progress);
-            send_response(client_sock, 200, "application/json", "{\"success\":true}", 16);
-        } else {
-            send_response(client_sock, 400, "application/json", 
-                         "{\"error\":\"Missing id\"}", 21);
-        }
+    
+    SimilarResult results[MAX_SIMILAR_RESULTS];
+    int count = find_similar(ctx->pokedex, id, k, type_filter, results);
+    if (count < 0) {
+        send_json(ctx, 404, "{\"error\":\"Pokemon not found\"}");
+        return;
     }
-    // POST /api/catch?id=25
-    else if (strncmp(path, "/api/catch", 10) == 0) {
-        char* id_param = strstr(path, "id=");
-        if (id_param) {
-            int id = atoi(id_param + 3);
-            mark_caught(progress, id);
-            save_user_progress("user_progress.dat", progress);
-            send_response(client_sock, 200, "application/json", "{\"success\":true}", 16);
-        } else {
-            send_response(client_sock, 400, "application/json", 
-                         "{\"error\":\"Missing id\"}", 21);
-        }
+    
+    char response[BUFFER_SIZE];
+    similar_to_json(ctx->pokedex, id, results, count, response, sizeof(response));
+    send_json(ctx, 200, response);
+}
+
+// POST /api/encounter?id=25
+static void handle_encounter(RequestContext* ctx) {
+    int id;
+    if (!require_id(ctx, &id)) return;
+    
+    mark_encountered(ctx->progress, id);
+    progress_saver(ctx->progress);
+    send_json(ctx, 200, "{\"success\":true}");
+}
+
+// POST /api/catch?id=25
+static void handle_catch(RequestContext* ctx) {
+    int id;
+    if (!require_id(ctx, &id)) return;
+    
+    mark_caught(ctx->progress, id);
+    progress_saver(ctx->progress);
+    send_json(ctx, 200, "{\"success\":true}");
+}
+
+// POST /api/reset?id=25 - Reset a specific Pokemon
+static void handle_reset(RequestContext* ctx) {
+    int id;
+    if (!require_id(ctx, &id)) return;
+    
+    reset_pokemon(ctx->progress, id);
+    progress_saver(ctx->progress);
+    send_json(ctx, 200, "{\"success\":true}");
+}
+
+// POST /api/reset-all - Reset all progress
+static void handle_reset_all(RequestContext* ctx) {
+    reset_all_progress(ctx->progress);
+    progress_saver(ctx->progress);
+    send_json(ctx, 200, "{\"success\":true}");
+}
+
+// GET / - Serve HTML
+static void handle_index(RequestContext* ctx) {
+    FILE* f = fopen("pokedex.html", "r");
+    if (f) {
+        fseek(f, 0, SEEK_END);
+        long fsize = ftell(f);
+        fseek(f, 0, SEEK_SET);
+        
+        char* html = malloc(fsize + 1);
+        fread(html, 1, fsize, f);
+        html[fsize] = '\0';
+        fclose(f);
+        
+        send_response(ctx->out, 200, "text/html", html, fsize);
+        free(html);
+    } else {
+        send_response(ctx->out, 404, "text/plain", "404 Not Found", 13);
     }
-    // POST /api/reset?id=25 - Reset a specific Pokemon
-    else if (strncmp(path, "/api/reset", 10) == 0) {
-        char* id_param = strstr(path, "id=");
-        if (id_param) {
-            int id = atoi(id_param + 3);
-            reset_pokemon(progress, id);
-            save_user_progress("user_progress.dat", progress);
-            send_response(client_sock, 200, "application/json", "{\"success\":true}", 16);
-        } else {
-            send_response(client_sock, 400, "application/json", 
-                         "{\"error\":\"Missing id\"}", 21);
+}
+
+static const Route routes[] = {
+    { HTTP_GET,  "/",               handle_index },
+    { HTTP_GET,  "/index.html",     handle_index },
+    { HTTP_GET,  "/api/progress",   handle_progress },
+    { HTTP_GET,  "/api/stats/completion", handle_completion },
+    { HTTP_GET,  "/api/list",       handle_list },
+    { HTTP_GET,  "/api/search",     handle_search },
+    { HTTP_GET,  "/api/matchup",    handle_matchup },
+    { HTTP_GET,  "/api/coverage",   handle_coverage },
+    { HTTP_GET,  "/api/similar",    handle_similar },
+    { HTTP_POST, "/api/encounter",  handle_encounter },
+    { HTTP_POST, "/api/catch",      handle_catch },
+    { HTTP_POST, "/api/reset",      handle_reset },
+    { HTTP_POST, "/api/reset-all",  handle_reset_all },
+};
+
+/**
+ * Compile the route table. Call once before serving requests
+ * Returns 1 on success, 0 on failure
+ */
+int init_routes(void) {
+    return router_build(&router, routes, (int)(sizeof(routes) / sizeof(routes[0])));
+}
+
+/**
+ * Replace the progress saver used by the POST handlers (NULL = blocking file write)
+ */
+void set_progress_saver(ProgressSaver saver) {
+    progress_saver = saver ? saver : save_progress_file;
+}
+
+/**
+ * Reply 405 with an Allow header listing the methods the path accepts
+ */
+static void send_method_not_allowed(ResponseBuffer* out, unsigned int allowed) {
+    static const char* names[HTTP_METHOD_COUNT] = { "GET", "POST", "OPTIONS" };
+    
+    char headers[64] = "Allow: ";
+    size_t len = strlen(headers);
+    for (int m = 0; m < HTTP_METHOD_COUNT; m++) {
+        if (allowed & (1u << m)) {
+            len += snprintf(headers + len, sizeof(headers) - len, "%s, ", names[m]);
         }
     }
-    // POST /api/reset-all - Reset all progress
-    else if (strcmp(path, "/api/reset-all") == 0) {
-        reset_all_progress(progress);
-        save_user_progress("user_progress.dat", progress);
-        send_response(client_sock, 200, "application/json", "{\"success\":true}", 16);
-    }
-    // Serve HTML
-    else if (strcmp(path, "/") == 0 || strcmp(path, "/index.html") == 0) {
-        FILE* f = fopen("pokedex.html", "r");
-        if (f) {
-            fseek(f, 0, SEEK_END);
-            long fsize = ftell(f);
-            fseek(f, 0, SEEK_SET);
-            
-            char* html = malloc(fsize + 1);
-            fread(html, 1, fsize, f);
-            html[fsize] = '\0';
-            fclose(f);
-            
-            send_response(client_sock, 200, "text/html", html, fsize);
-            free(html);
-        } else {
-            send_response(client_sock, 404, "text/plain", "404 Not Found", 13);
-        }
+    snprintf(headers + len, sizeof(headers) - len, "OPTIONS\r\n");
+    
+    send_response_headers(out, 405, "application/json", headers,
+                          "{\"error\":\"Method not allowed\"}", 30);
+}
+
+/**
+ * Handle incoming HTTP request
+ */
+void handle_request(ResponseBuffer* out, const char* request,
+                    PokedexData* pokedex, UserProgress* progress) {
+    HttpRequest req;
+    if (!parse_request_line(request, &req)) {
+        send_response(out, 400, "text/plain", "400 Bad Request", 15);
+        return;
     }
-    else {
-        send_response(client_sock, 404, "text/plain", "404 Not Found", 13);
+    
+    // Handle OPTIONS for CORS
+    if (req.method == HTTP_OPTIONS) {
+        send_response(out, 200, "text/plain", "", 0);
+        return;
+    }
+    
+    unsigned int allowed;
+    RouteHandler handler = router_lookup(&router, req.method, req.path, req.path_len, &allowed);
+    
+    if (handler) {
+        RequestContext ctx = { out, &req, pokedex, progress };
+        handler(&ctx);
+    } else if (allowed) {
+        send_method_not_allowed(out, allowed);
+    } else {
+        send_response(out, 404, "text/plain", "404 Not Found", 13);
     }
 }
@@ -5,6 +5,7 @@
 
 #include <stdio.h>
 #include <string.h>
+#include <math.h>
 #include "../include/pokemon.h"
 
 /**
@@ -24,9 +25,13 @@ static void escape_json_string(const char* src, char* dest, size_t max_len) {
 /**
  * Convert a Pokemon to JSON format
  */
-void pokemon_to_json(Pokemon* p, ProgressEntry* prog, char* buffer, size_t size) {
+void pokemon_to_json(PokedexData* pokedex, Pokemon* p, ProgressEntry* prog,
+                     char* buffer, size_t size) {
+    PokemonText* text = &pokedex->text[p - pokedex->pokemon_array];
+    
     char desc_escaped[512];
-    escape_json_string(p->description, desc_escaped, sizeof(desc_escaped));
+    escape_json_string(pokedex_string(pokedex, text->description),
+                       desc_escaped, sizeof(desc_escaped));
     
     snprintf(buffer, size,
         "{"
@@ -46,10 +51,12 @@ void pokemon_to_json(Pokemon* p, ProgressEntry* prog, char* buffer, size_t size)
         "\"encountered\":%s,"
         "\"caught\":%s"
         "}",
-        p->id, p->name, p->type1, p->type2,
+        p->id, pokedex_string(pokedex, p->name),
+        type_name(p->type1_id), type_name(p->type2_id),
         p->hp, p->attack, p->defense,
         p->sp_attack, p->sp_defense, p->speed,
-        p->ability1, p->ability2, desc_escaped,
+        pokedex_string(pokedex, text->ability1), pokedex_string(pokedex, text->ability2),
+        desc_escaped,
         prog && prog->encountered ? "true" : "false",
         prog && prog->caught ? "true" : "false"
     );
@@ -70,6 +77,53 @@ void progress_to_json(UserProgress* progress, char* buffer, size_t size) {
     );
 }
 
+/**
+ * Convert per-type and per-generation completion counters to JSON
+ */
+void completion_to_json(UserProgress* progress, char* buffer, size_t size) {
+    char* ptr = buffer;
+    size_t remaining = size;
+    int written;
+    
+    written = snprintf(ptr, remaining,
+        "{\"total\":151,\"seen\":%d,\"caught\":%d,\"types\":[",
+        progress->total_encountered, progress->total_caught);
+    ptr += written;
+    remaining -= written;
+    
+    bool first = true;
+    for (int t = 0; t < TYPE_COUNT && remaining > 100; t++) {
+        CompletionCounter* c = &progress->by_type[t];
+        if (c->total == 0) continue;
+        
+        written = snprintf(ptr, remaining,
+            "%s{\"type\":\"%s\",\"total\":%d,\"seen\":%d,\"caught\":%d}",
+            first ? "" : ",", type_name(t), c->total, c->seen, c->caught);
+        ptr += written;
+        remaining -= written;
+        first = false;
+    }
+    
+    written = snprintf(ptr, remaining, "],\"generations\":[");
+    ptr += written;
+    remaining -= written;
+    
+    first = true;
+    for (int g = 0; g < MAX_GENERATIONS && remaining > 100; g++) {
+        CompletionCounter* c = &progress->by_generation[g];
+        if (c->total == 0) continue;
+        
+        written = snprintf(ptr, remaining,
+            "%s{\"generation\":%d,\"total\":%d,\"seen\":%d,\"caught\":%d}",
+            first ? "" : ",", g + 1, c->total, c->seen, c->caught);
+        ptr += written;
+        remaining -= written;
+        first = false;
+    }
+    
+    snprintf(ptr, remaining, "]}");
+}
+
 /**
  * Convert Pokemon list to JSON array
  */
@@ -100,7 +154,7 @@ void list_to_json(PokedexData* pokedex, UserProgress* progress,
             }
             
             char poke_json[1024];
-            pokemon_to_json(p, prog, poke_json, sizeof(poke_json));
+            pokemon_to_json(pokedex, p, prog, poke_json, sizeof(poke_json));
             written = snprintf(ptr, remaining, "%s", poke_json);
             ptr += written;
             remaining -= written;
@@ -111,3 +165,88 @@ void list_to_json(PokedexData* pokedex, UserProgress* progress,
     
     snprintf(ptr, remaining, "]");
 }
+
+/**
+ * Convert a type matchup to JSON (an error object if a type id is out of range)
+ */
+void matchup_to_json(int attacker, int defender1, int defender2, char* buffer, size_t size) {
+    int mult = type_effectiveness(attacker, defender1, defender2);
+    if (mult < 0) {
+        snprintf(buffer, size, "{\"error\":\"Unknown type\"}");
+        return;
+    }
+    
+    snprintf(buffer, size,
+        "{"
+        "\"attacker\":\"%s\","
+        "\"defender1\":\"%s\","
+        "\"defender2\":\"%s\","
+        "\"multiplier\":%g"
+        "}",
+        type_name(attacker), type_name(defender1), type_name(defender2),
+        mult / 4.0
+    );
+}
+
+/**
+ * Convert team coverage scores to JSON
+ */
+void coverage_to_json(TeamCoverage* coverage, char* buffer, size_t size) {
+    char* ptr = buffer;
+    size_t remaining = size;
+    int written;
+    
+    int total = coverage->super_effective + coverage->neutral +
+                coverage->resisted + coverage->immune;
+    
+    written = snprintf(ptr, remaining,
+        "{"
+        "\"offense\":{"
+        "\"super_effective\":%d,"
+        "\"neutral\":%d,"
+        "\"resisted\":%d,"
+        "\"immune\":%d,"
+        "\"score\":%.3f"
+        "},"
+        "\"defense\":[",
+        coverage->super_effective, coverage->neutral,
+        coverage->resisted, coverage->immune,
+        total > 0 ? (double)coverage->super_effective / total : 0.0
+    );
+    ptr += written;
+    remaining -= written;
+    
+    for (int m = 0; m < coverage->team_size; m++) {
+        written = snprintf(ptr, remaining, "%s{\"id\":%d,\"threatened_by\":%d}",
+                           m > 0 ? "," : "", coverage->team_ids[m], coverage->threatened_by[m]);
+        ptr += written;
+        remaining -= written;
+    }
+    
+    snprintf(ptr, remaining, "]}");
+}
+
+/**
+ * Convert stat-similarity results to JSON
+ */
+void similar_to_json(PokedexData* pokedex, int id, SimilarResult* results, int count,
+                     char* buffer, size_t size) {
+    char* ptr = buffer;
+    size_t remaining = size;
+    int written;
+    
+    written = snprintf(ptr, remaining, "{\"id\":%d,\"results\":[", id);
+    ptr += written;
+    remaining -= written;
+    
+    for (int i = 0; i < count && remaining > 100; i++) {
+        Pokemon* p = search_by_id(pokedex, results[i].id);
+        written = snprintf(ptr, remaining, "%s{\"id\":%d,\"name\":\"%s\",\"distance\":%.2f}",
+                           i > 0 ? "," : "", p->id, pokedex_string(pokedex, p->name),
+                           sqrt((double)results[i].distance));
+        ptr += written;
+        remaining -= written;
+    }
+    
+    snprintf(ptr, remaining, "]}");
+}
@@ -22,12 +22,26 @@
 #endif
 
 #define PORT 8080
-#define BUFFER_SIZE 65536
+#define DEFAULT_BACKLOG 128
+#define DEFAULT_MAX_CONNECTIONS 256
+#define DEFAULT_RATE_PER_SEC 50
+#define DEFAULT_BURST 100
+#define DEFAULT_HEADER_TIMEOUT_MS 10000
+#define DEFAULT_BODY_TIMEOUT_MS 10000
+#define DEFAULT_WRITE_TIMEOUT_MS 10000
+#define DEFAULT_IDLE_TIMEOUT_MS 5000
+#define DEFAULT_DRAIN_TIMEOUT_MS 2000
+#define DEFAULT_LOG_SAMPLE 1
 
 // Global data
 static PokedexData global_pokedex;
 static UserProgress global_progress;
 
+static void print_loader_message(const char* message) {
+    printf("%s\n", message);
+    fflush(stdout);
+}
+
 int main(int argc, char* argv[]) {
     #ifdef _WIN32
     WSADATA wsa;
@@ -39,7 +53,25 @@ int main(int argc, char* argv[]) {
     
     // Check for command line arguments
     bool reset_progress = false;
-    bool reset_pokemon_id = 0;
+    int reset_pokemon_id = 0;
+    const char* takeover_path = NULL;
+    int inherit_fd = -1;
+    ServerConfig config = {
+        .port = PORT,
+        .backlog = DEFAULT_BACKLOG,
+        .max_connections = DEFAULT_MAX_CONNECTIONS,
+        .rate_per_sec = DEFAULT_RATE_PER_SEC,
+        .burst = DEFAULT_BURST,
+        .header_timeout_ms = DEFAULT_HEADER_TIMEOUT_MS,
+        .body_timeout_ms = DEFAULT_BODY_TIMEOUT_MS,
+        .write_timeout_ms = DEFAULT_WRITE_TIMEOUT_MS,
+        .idle_timeout_ms = DEFAULT_IDLE_TIMEOUT_MS,
+        .drain_timeout_ms = DEFAULT_DRAIN_TIMEOUT_MS,
+        .handoff_path = NULL,
+        .access_log_path = "-",
+        .log_sample = DEFAULT_LOG_SAMPLE,
+        .io_uring = true
+    };
     
     for (int i = 1; i < argc; i++) {
         if (strcmp(argv[i], "--reset") == 0 || strcmp(argv[i], "-r") == 0) {
@@ -48,11 +80,86 @@ int main(int argc, char* argv[]) {
         else if (strcmp(argv[i], "--reset-id") == 0 && i + 1 < argc) {
             reset_pokemon_id = atoi(argv[++i]);
         }
+        else if (strcmp(argv[i], "--port") == 0 && i + 1 < argc) {
+            config.port = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--backlog") == 0 && i + 1 < argc) {
+            config.backlog = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--max-conns") == 0 && i + 1 < argc) {
+            config.max_connections = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--rate") == 0 && i + 1 < argc) {
+            config.rate_per_sec = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--burst") == 0 && i + 1 < argc) {
+            config.burst = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--header-timeout") == 0 && i + 1 < argc) {
+            config.header_timeout_ms = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--body-timeout") == 0 && i + 1 < argc) {
+            config.body_timeout_ms = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--write-timeout") == 0 && i + 1 < argc) {
+            config.write_timeout_ms = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--idle-timeout") == 0 && i + 1 < argc) {
+            config.idle_timeout_ms = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--drain-timeout") == 0 && i + 1 < argc) {
+            config.drain_timeout_ms = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--handoff-socket") == 0 && i + 1 < argc) {
+            config.handoff_path = argv[++i];
+        }
+        else if (strcmp(argv[i], "--takeover") == 0 && i + 1 < argc) {
+            takeover_path = argv[++i];
+            config.handoff_path = takeover_path;
+        }
+        else if (strcmp(argv[i], "--inherit-fd") == 0 && i + 1 < argc) {
+            inherit_fd = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--access-log") == 0 && i + 1 < argc) {
+            i++;
+            config.access_log_path = strcmp(argv[i], "off") == 0 ? NULL : argv[i];
+        }
+        else if (strcmp(argv[i], "--log-sample") == 0 && i + 1 < argc) {
+            config.log_sample = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--no-io-uring") == 0) {
+            config.io_uring = false;
+        }
         else if (strcmp(argv[i], "--help") == 0 || strcmp(argv[i], "-h") == 0) {
             printf("Usage: pokedex_server [options]\n");
             printf("Options:\n");
             printf("  --reset, -r       Reset all progress on startup\n");
             printf("  --reset-id <id>   Reset specific Pokemon by ID\n");
+            printf("  --port <n>        Listen port (default %d)\n", PORT);
+            printf("  --backlog <n>     Listen queue length (default %d)\n", DEFAULT_BACKLOG);
+            printf("  --max-conns <n>   Open connections before shedding with 503 (default %d)\n",
+                   DEFAULT_MAX_CONNECTIONS);
+            printf("  --rate <n>        Requests per second per client, 0 = unlimited (default %d)\n",
+                   DEFAULT_RATE_PER_SEC);
+            printf("  --burst <n>       Requests a client may burst above the rate (default %d)\n",
+                   DEFAULT_BURST);
+            printf("  --header-timeout <ms>  Time allowed to send request headers (default %d)\n",
+                   DEFAULT_HEADER_TIMEOUT_MS);
+            printf("  --body-timeout <ms>    Time allowed to send a request body (default %d)\n",
+                   DEFAULT_BODY_TIMEOUT_MS);
+            printf("  --write-timeout <ms>   Time allowed to read the response (default %d)\n",
+                   DEFAULT_WRITE_TIMEOUT_MS);
+            printf("  --idle-timeout <ms>    Keep-alive idle time before closing (default %d)\n",
+                   DEFAULT_IDLE_TIMEOUT_MS);
+            printf("  --drain-timeout <ms>   Time in-flight requests get on shutdown or handoff (default %d)\n",
+                   DEFAULT_DRAIN_TIMEOUT_MS);
+            printf("  --handoff-socket <path>  Hand the listening socket to a replacement on request\n");
+            printf("  --takeover <path>        Take the listening socket over from a running server\n");
+            printf("  --inherit-fd <fd>        Serve on an already listening socket\n");
+            printf("  --access-log <path>      Access log file, - = stdout, off = none (default -)\n");
+            printf("  --log-sample <n>         Log every nth request; 5xx always logged (default %d)\n",
+                   DEFAULT_LOG_SAMPLE);
+            printf("  --no-io-uring            Use the poll() loop even when io_uring is available\n");
             printf("  --help, -h        Show this help message\n");
             return 0;
         }
@@ -61,75 +168,60 @@ int main(int argc, char* argv[]) {
     printf("Loading Pokemon data...\n");
     fflush(stdout);
     
+    pokedex_set_logger(print_loader_message);
     if (!load_pokemon_data("pokemon_data.csv", &global_pokedex)) {
         printf("Failed to load Pokemon data!\n");
         fflush(stdout);
         return 1;
     }
     
-    load_user_progress("user_progress.dat", &global_progress);
+    // Acquire the listener before reading progress: a takeover gets the socket
+    // at once, then waits until the old server has flushed its progress
+    int server_sock;
+    if (takeover_path) {
+        printf("Taking over from server at %s...\n", takeover_path);
+        fflush(stdout);
+        server_sock = handoff_receive(takeover_path);
+    } else if (inherit_fd >= 0) {
+        server_sock = inherit_fd;
+    } else {
+        server_sock = open_listener(&config);
+    }
+    
+    if (server_sock < 0) {
+        printf("Failed to acquire listening socket!\n");
+        return 1;
+    }
+    
+    load_user_progress(PROGRESS_FILE, &global_progress);
+    progress_bind_pokedex(&global_progress, &global_pokedex);
     
     // Handle reset options
     if (reset_progress) {
         printf("Resetting ALL progress...\n");
         reset_all_progress(&global_progress);
-        save_user_progress("user_progress.dat", &global_progress);
+        save_user_progress(PROGRESS_FILE, &global_progress);
         printf("Progress reset complete!\n");
     }
     else if (reset_pokemon_id > 0) {
         printf("Resetting Pokemon #%d...\n", reset_pokemon_id);
         reset_pokemon(&global_progress, reset_pokemon_id);
-        save_user_progress("user_progress.dat", &global_progress);
+        save_user_progress(PROGRESS_FILE, &global_progress);
         printf("Pokemon #%d reset complete!\n", reset_pokemon_id);
     }
     
-    int server_sock = socket(AF_INET, SOCK_STREAM, 0);
-    if (server_sock < 0) {
-        printf("Socket creation failed\n");
+    if (!init_routes()) {
+        printf("Failed to build route table!\n");
         return 1;
     }
     
-    int opt = 1;
-    setsockopt(server_sock, SOL_SOCKET, SO_REUSEADDR, (char*)&opt, sizeof(opt));
-    
-    struct sockaddr_in server_addr;
-    server_addr.sin_family = AF_INET;
-    server_addr.sin_addr.s_addr = INADDR_ANY;
-    server_addr.sin_port = htons(PORT);
-    
-    if (bind(server_sock, (struct sockaddr*)&server_addr, sizeof(server_addr)) < 0) {
-        printf("Bind failed\n");
-        return 1;
-    }
-    
-    listen(server_sock, 5);
-    
-    printf("Server running on http://localhost:%d\n", PORT);
-    printf("Open your browser and go to http://localhost:%d\n\n", PORT);
-    
-    while (1) {
-        struct sockaddr_in client_addr;
-        socklen_t addr_len = sizeof(client_addr);
-        int client_sock = accept(server_sock, (struct sockaddr*)&client_addr, &addr_len);
-        
-        if (client_sock < 0) continue;
-        
-        char buffer[BUFFER_SIZE];
-        int received = recv(client_sock, buffer, BUFFER_SIZE - 1, 0);
-        if (received > 0) {
-            buffer[received] = '\0';
-            handle_request(client_sock, buffer, &global_pokedex, &global_progress);
-        }
-        
-        closesocket(client_sock);
-    }
+    int result = run_server(&config, server_sock, &global_pokedex, &global_progress);
     
-    closesocket(server_sock);
-    bst_destroy(global_pokedex.name_bst_root);
+    free_pokemon_data(&global_pokedex);
     
     #ifdef _WIN32
     WSACleanup();
     #endif
     
-    return 0;
+    return result;
 }
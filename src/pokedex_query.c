@@ -0,0 +1,347 @@
+/**
+ * pokedex_query.c - Batch query tool built on libpokedex
+ * Reads newline-delimited queries from a file or stdin, answers them
+ * in-process across worker threads and streams one JSON line per query
+ * in input order
+ *
+ * Queries:
+ *   id <n>
+ *   name <name>
+ *   similar <id> [k] [type,type...]
+ *   matchup <attacker> <defender>[,<defender2>]
+ *   coverage <id>,<id>,...
+ *   completion
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "../include/pokedex.h"
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <unistd.h>
+#endif
+
+#define QUERY_LINE_MAX 256
+#define RESULT_MAX 8192
+#define DEFAULT_BATCH 4096
+#define MAX_THREADS 64
+
+typedef struct {
+    char (*lines)[QUERY_LINE_MAX];
+    int count;
+} Batch;
+
+typedef struct {
+    pthread_t thread;
+    bool running;
+    PokedexData* pokedex;
+    UserProgress* progress;
+    Batch* batch;
+    int first;                  // Workers own contiguous line ranges, so
+    int last;                   // concatenating their output keeps input order
+    char* out;
+    size_t len;
+    size_t cap;
+} Worker;
+
+static void append(Worker* worker, const char* text, size_t len) {
+    if (worker->len + len > worker->cap) {
+        size_t cap = worker->cap ? worker->cap * 2 : 65536;
+        while (cap < worker->len + len) cap *= 2;
+        char* grown = realloc(worker->out, cap);
+        if (!grown) return;
+        worker->out = grown;
+        worker->cap = cap;
+    }
+    memcpy(worker->out + worker->len, text, len);
+    worker->len += len;
+}
+
+static int parse_team(char* list, int* ids) {
+    int count = 0;
+    for (char* p = list; *p; ) {
+        char* end;
+        long id = strtol(p, &end, 10);
+        if (end == p || count == MAX_TEAM_SIZE || (*end != ',' && *end != '\0')) return 0;
+        ids[count++] = (int)id;
+        p = *end ? end + 1 : end;
+    }
+    return count;
+}
+
+/**
+ * Answer one query into result. Same JSON as the matching HTTP endpoint
+ */
+static void run_query(Worker* worker, char* line, char* result, size_t size) {
+    PokedexData* pokedex = worker->pokedex;
+    char* save;
+    char* command = strtok_r(line, " \t", &save);
+    char* arg = strtok_r(NULL, " \t", &save);
+
+    if (strcmp(command, "id") == 0 || strcmp(command, "name") == 0) {
+        Pokemon* p = NULL;
+        if (arg) {
+            p = command[0] == 'i' ? search_by_id(pokedex, atoi(arg)) : search_by_name(pokedex, arg);
+        }
+        if (p) {
+            pokemon_to_json(pokedex, p, get_progress(worker->progress, p->id), result, size);
+        } else {
+            snprintf(result, size, "{\"error\":\"Pokemon not found\"}");
+        }
+    }
+    else if (strcmp(command, "similar") == 0 && arg) {
+        int id = atoi(arg);
+        char* k_arg = strtok_r(NULL, " \t", &save);
+        char* types = strtok_r(NULL, " \t", &save);
+
+        unsigned int type_filter = 0;
+        char* type_save;
+        for (char* name = types ? strtok_r(types, ",", &type_save) : NULL; name;
+             name = strtok_r(NULL, ",", &type_save)) {
+            int type_id = type_from_name(name);
+            if (type_id == TYPE_NONE) {
+                snprintf(result, size, "{\"error\":\"Unknown type\"}");
+                return;
+            }
+            type_filter |= 1u << type_id;
+        }
+
+        SimilarResult results[MAX_SIMILAR_RESULTS];
+        int count = find_similar(pokedex, id, k_arg ? atoi(k_arg) : 10, type_filter, results);
+        if (count < 0) {
+            snprintf(result, size, "{\"error\":\"Pokemon not found\"}");
+        } else {
+            similar_to_json(pokedex, id, results, count, result, size);
+        }
+    }
+    else if (strcmp(command, "matchup") == 0 && arg) {
+        int attacker = type_from_name(arg);
+        char* defender = strtok_r(NULL, " \t", &save);
+        int defender1 = TYPE_NONE, defender2 = TYPE_NONE;
+        if (defender) {
+            char* second = strchr(defender, ',');
+            if (second) *second++ = '\0';
+            defender1 = type_from_name(defender);
+            if (second) defender2 = type_from_name(second);
+            if (second && defender2 == TYPE_NONE) defender1 = TYPE_NONE;
+        }
+        if (attacker == TYPE_NONE || defender1 == TYPE_NONE) {
+            snprintf(result, size, "{\"error\":\"Unknown or missing type\"}");
+        } else {
+            matchup_to_json(attacker, defender1, defender2, result, size);
+        }
+    }
+    else if (strcmp(command, "coverage") == 0 && arg) {
+        int ids[MAX_TEAM_SIZE];
+        int count = parse_team(arg, ids);
+        TeamCoverage coverage;
+        if (count == 0 || !score_team(pokedex, ids, count, &coverage)) {
+            snprintf(result, size, "{\"error\":\"team must be 1-6 comma-separated Pokemon ids\"}");
+        } else {
+            coverage_to_json(&coverage, result, size);
+        }
+    }
+    else if (strcmp(command, "completion") == 0) {
+        completion_to_json(worker->progress, result, size);
+    }
+    else {
+        snprintf(result, size, "{\"error\":\"Unknown query\"}");
+    }
+}
+
+static void* worker_main(void* arg) {
+    Worker* worker = (Worker*)arg;
+    char result[RESULT_MAX];
+
+    worker->len = 0;
+    for (int i = worker->first; i < worker->last; i++) {
+        char* line = worker->batch->lines[i];
+        if (line[0] == '\0') {
+            snprintf(result, sizeof(result), "{\"error\":\"Query too long\"}");
+        } else {
+            run_query(worker, line, result, sizeof(result));
+        }
+        size_t len = strlen(result);
+        result[len++] = '\n';
+        append(worker, result, len);
+    }
+    return NULL;
+}
+
+/**
+ * Read up to capacity non-blank queries. Over-long lines are kept as an
+ * empty slot so their error still lines up with the input
+ */
+static int read_batch(FILE* input, Batch* batch, int capacity) {
+    batch->count = 0;
+    while (batch->count < capacity) {
+        char* line = batch->lines[batch->count];
+        if (!fgets(line, QUERY_LINE_MAX, input)) break;
+
+        size_t len = strlen(line);
+        if (len == QUERY_LINE_MAX - 1 && line[len - 1] != '\n') {
+            int c;
+            while ((c = fgetc(input)) != EOF && c != '\n') { }
+            line[0] = '\0';
+            batch->count++;
+            continue;
+        }
+
+        while (len > 0 && (line[len - 1] == '\n' || line[len - 1] == '\r')) line[--len] = '\0';
+        char* start = line + strspn(line, " \t");
+        if (*start == '\0' || *start == '#') continue;
+        if (start != line) memmove(line, start, strlen(start) + 1);
+        batch->count++;
+    }
+    return batch->count;
+}
+
+/**
+ * Answer a batch on up to thread_count workers, then write it out in order
+ */
+static void run_batch(Worker* workers, int thread_count, Batch* batch, Batch* next,
+                      FILE* input, int batch_size) {
+    int per_worker = (batch->count + thread_count - 1) / thread_count;
+    int started = 0;
+
+    for (int i = 0; i < thread_count; i++) {
+        workers[i].batch = batch;
+        workers[i].first = i * per_worker;
+        workers[i].last = workers[i].first + per_worker;
+        if (workers[i].last > batch->count) workers[i].last = batch->count;
+        if (workers[i].first >= workers[i].last) break;
+
+        workers[i].running = i > 0 &&
+            pthread_create(&workers[i].thread, NULL, worker_main, &workers[i]) == 0;
+        started++;
+    }
+
+    // Read ahead while the workers run; worker 0 runs here afterwards
+    read_batch(input, next, batch_size);
+    worker_main(&workers[0]);
+    for (int i = 0; i < started; i++) {
+        if (workers[i].running) pthread_join(workers[i].thread, NULL);
+        else if (i > 0) worker_main(&workers[i]);
+        fwrite(workers[i].out, 1, workers[i].len, stdout);
+    }
+    fflush(stdout);
+}
+
+static int online_cpus(void) {
+    #ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (int)info.dwNumberOfProcessors;
+    #else
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    return cpus > 0 ? (int)cpus : 1;
+    #endif
+}
+
+static void print_loader_message(const char* message) {
+    fprintf(stderr, "%s\n", message);
+}
+
+static void print_usage(void) {
+    printf("Usage: pokedex-query [options] [query-file]\n");
+    printf("Reads one query per line from query-file (or stdin) and prints one\n");
+    printf("JSON result per line, in input order.\n");
+    printf("Options:\n");
+    printf("  --data <csv>       Pokemon data file (default pokemon_data.csv)\n");
+    printf("  --progress <file>  Progress file for seen/caught fields (read only)\n");
+    printf("  --threads <n>      Worker threads (default: online CPUs)\n");
+    printf("  --batch <n>        Queries per batch (default %d)\n", DEFAULT_BATCH);
+    printf("Queries:\n");
+    printf("  id <n> | name <name> | similar <id> [k] [types] |\n");
+    printf("  matchup <attacker> <defender>[,<defender2>] | coverage <ids> | completion\n");
+}
+
+int main(int argc, char* argv[]) {
+    const char* data_file = "pokemon_data.csv";
+    const char* progress_file = NULL;
+    const char* query_file = NULL;
+    int thread_count = online_cpus();
+    int batch_size = DEFAULT_BATCH;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--data") == 0 && i + 1 < argc) {
+            data_file = argv[++i];
+        }
+        else if (strcmp(argv[i], "--progress") == 0 && i + 1 < argc) {
+            progress_file = argv[++i];
+        }
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            thread_count = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--batch") == 0 && i + 1 < argc) {
+            batch_size = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--help") == 0 || strcmp(argv[i], "-h") == 0) {
+            print_usage();
+            return 0;
+        }
+        else if (argv[i][0] != '-' || strcmp(argv[i], "-") == 0) {
+            query_file = argv[i];
+        }
+        else {
+            fprintf(stderr, "Unknown option: %s\n", argv[i]);
+            return 1;
+        }
+    }
+    if (thread_count < 1) thread_count = 1;
+    if (thread_count > MAX_THREADS) thread_count = MAX_THREADS;
+    if (batch_size < 1) batch_size = DEFAULT_BATCH;
+
+    FILE* input = stdin;
+    if (query_file && strcmp(query_file, "-") != 0) {
+        input = fopen(query_file, "r");
+        if (!input) {
+            fprintf(stderr, "Error: Could not open %s\n", query_file);
+            return 1;
+        }
+    }
+
+    // Loader errors go to stderr, keeping stdout for results
+    static PokedexData pokedex;
+    static UserProgress progress;
+    pokedex_set_logger(print_loader_message);
+    if (!load_pokemon_data(data_file, &pokedex)) return 1;
+    if (progress_file) load_user_progress(progress_file, &progress);
+    else initialize_progress(&progress);
+    progress_bind_pokedex(&progress, &pokedex);
+
+    Worker workers[MAX_THREADS];
+    memset(workers, 0, sizeof(workers));
+    for (int i = 0; i < thread_count; i++) {
+        workers[i].pokedex = &pokedex;
+        workers[i].progress = &progress;
+    }
+
+    Batch batches[2];
+    for (int i = 0; i < 2; i++) {
+        batches[i].lines = malloc((size_t)batch_size * QUERY_LINE_MAX);
+        if (!batches[i].lines) {
+            fprintf(stderr, "Error: Out of memory\n");
+            return 1;
+        }
+    }
+
+    int current = 0;
+    read_batch(input, &batches[current], batch_size);
+    while (batches[current].count > 0) {
+        run_batch(workers, thread_count, &batches[current], &batches[current ^ 1],
+                  input, batch_size);
+        current ^= 1;
+    }
+
+    for (int i = 0; i < thread_count; i++) free(workers[i].out);
+    free(batches[0].lines);
+    free(batches[1].lines);
+    if (input != stdin) fclose(input);
+    free_pokemon_data(&pokedex);
+    return 0;
+}
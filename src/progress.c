@@ -3,8 +3,73 @@
  * Handles marking Pokemon as encountered/caught
  */
 
+#include <string.h>
 #include "../include/pokemon.h"
 
+// Last national dex number of each generation
+static const int generation_last_id[MAX_GENERATIONS] = {
+    151, 251, 386, 493, 649, 721, 809, 905, 1025
+};
+
+/**
+ * Generation (1-based) a national dex number belongs to, 0 if out of range
+ */
+int pokemon_generation(int pokemon_id) {
+    for (int g = 0; g < MAX_GENERATIONS; g++) {
+        if (pokemon_id >= 1 && pokemon_id <= generation_last_id[g]) return g + 1;
+    }
+    return 0;
+}
+
+/**
+ * Apply a seen/caught change for one Pokemon to its type and
+ * generation counters (O(1))
+ */
+static void adjust_aggregates(UserProgress* progress, int index, int seen_delta, int caught_delta) {
+    for (int slot = 0; slot < 2; slot++) {
+        int type_id = progress->species_types[index][slot];
+        if (type_id == TYPE_NONE) continue;
+        progress->by_type[type_id].seen += seen_delta;
+        progress->by_type[type_id].caught += caught_delta;
+    }
+    
+    int generation = progress->species_generation[index];
+    if (generation > 0) {
+        progress->by_generation[generation - 1].seen += seen_delta;
+        progress->by_generation[generation - 1].caught += caught_delta;
+    }
+}
+
+/**
+ * Record each species' types and generation and rebuild the completion
+ * counters from the loaded entries. Call once after loading progress
+ */
+void progress_bind_pokedex(UserProgress* progress, PokedexData* pokedex) {
+    memset(progress->species_types, TYPE_NONE, sizeof(progress->species_types));
+    memset(progress->species_generation, 0, sizeof(progress->species_generation));
+    memset(progress->by_type, 0, sizeof(progress->by_type));
+    memset(progress->by_generation, 0, sizeof(progress->by_generation));
+    
+    for (int i = 0; i < pokedex->count; i++) {
+        Pokemon* p = &pokedex->pokemon_array[i];
+        if (p->id < 1 || p->id > 151) continue;
+        
+        int index = p->id - 1;
+        progress->species_types[index][0] = p->type1_id;
+        progress->species_types[index][1] = p->type2_id;
+        progress->species_generation[index] = (unsigned char)pokemon_generation(p->id);
+        
+        progress->by_type[p->type1_id].total++;
+        if (p->type2_id != TYPE_NONE) progress->by_type[p->type2_id].total++;
+        if (progress->species_generation[index] > 0) {
+            progress->by_generation[progress->species_generation[index] - 1].total++;
+        }
+        
+        ProgressEntry* entry = &progress->entries[index];
+        adjust_aggregates(progress, index, entry->encountered ? 1 : 0, entry->caught ? 1 : 0);
+    }
+}
+
 /**
  * Mark a Pokemon as encountered
  */
@@ -15,6 +80,7 @@ void mark_encountered(UserProgress* progress, int pokemon_id) {
     if (!entry->encountered) {
         entry->encountered = true;
         progress->total_encountered++;
+        adjust_aggregates(progress, pokemon_id - 1, 1, 0);
     }
 }
 
@@ -29,11 +95,13 @@ void mark_caught(UserProgress* progress, int pokemon_id) {
     if (!entry->encountered) {
         entry->encountered = true;
         progress->total_encountered++;
+        adjust_aggregates(progress, pokemon_id - 1, 1, 0);
     }
     
     if (!entry->caught) {
         entry->caught = true;
         progress->total_caught++;
+        adjust_aggregates(progress, pokemon_id - 1, 0, 1);
     }
 }
 
@@ -56,11 +124,13 @@ void reset_pokemon(UserProgress* progress, int pokemon_id) {
     if (entry->caught) {
         entry->caught = false;
         progress->total_caught--;
+        adjust_aggregates(progress, pokemon_id - 1, 0, -1);
     }
     
     if (entry->encountered) {
         entry->encountered = false;
         progress->total_encountered--;
+        adjust_aggregates(progress, pokemon_id - 1, -1, 0);
     }
 }
 
@@ -74,4 +144,13 @@ void reset_all_progress(UserProgress* progress) {
     }
     progress->total_encountered = 0;
     progress->total_caught = 0;
+    
+    for (int t = 0; t < TYPE_COUNT; t++) {
+        progress->by_type[t].seen = 0;
+        progress->by_type[t].caught = 0;
+    }
+    for (int g = 0; g < MAX_GENERATIONS; g++) {
+        progress->by_generation[g].seen = 0;
+        progress->by_generation[g].caught = 0;
+    }
 }
@@ -0,0 +1,117 @@
+/**
+ * ratelimit.c - Per-client token buckets
+ * Compact chained hash table keyed on IPv4 address; idle buckets are
+ * evicted by the timer wheel once they would have refilled completely
+ */
+
+#include <string.h>
+#include "../include/pokemon.h"
+
+#define TOKEN_SCALE 1000    // Buckets hold milli-tokens
+#define NO_ENTRY    -1
+
+static unsigned int ip_hash(unsigned int ip) {
+    ip ^= ip >> 16;
+    ip *= 0x45d9f3bu;
+    ip ^= ip >> 16;
+    return ip & (RATE_LIMIT_BUCKETS - 1);
+}
+
+/**
+ * Initialize the limiter. rate_per_sec == 0 disables limiting
+ */
+void ratelimit_init(RateLimiter* limiter, int rate_per_sec, int burst, unsigned long long now_ms) {
+    memset(limiter, 0, sizeof(RateLimiter));
+    limiter->rate_per_sec = rate_per_sec;
+    limiter->burst = burst > 0 ? burst : 1;
+
+    for (int i = 0; i < RATE_LIMIT_BUCKETS; i++) {
+        limiter->heads[i] = NO_ENTRY;
+    }
+
+    // Chain every entry onto the free list
+    for (int i = 0; i < RATE_LIMIT_ENTRIES; i++) {
+        limiter->entries[i].next = i + 1 < RATE_LIMIT_ENTRIES ? i + 1 : NO_ENTRY;
+    }
+    limiter->free_head = 0;
+
+    timer_wheel_init(&limiter->expiry, now_ms, 1000);
+}
+
+/**
+ * Remove an entry from its hash chain and return it to the free list
+ */
+static void release_entry(RateLimiter* limiter, int index) {
+    RateLimitEntry* entry = &limiter->entries[index];
+    int* link = &limiter->heads[ip_hash(entry->ip)];
+
+    while (*link != index) {
+        link = &limiter->entries[*link].next;
+    }
+    *link = entry->next;
+
+    entry->next = limiter->free_head;
+    limiter->free_head = index;
+    limiter->active--;
+}
+
+static void on_bucket_idle(TimerNode* node, void* ctx) {
+    RateLimiter* limiter = (RateLimiter*)ctx;
+    RateLimitEntry* entry = (RateLimitEntry*)node;
+    release_entry(limiter, (int)(entry - limiter->entries));
+}
+
+/**
+ * Take one token for ip. Returns 0 if the request is allowed, RATE_LIMIT_FULL
+ * if every bucket is in use, otherwise the number of seconds the client
+ * should wait before retrying
+ */
+int ratelimit_check(RateLimiter* limiter, unsigned int ip, unsigned long long now_ms) {
+    if (limiter->rate_per_sec <= 0) return 0;
+
+    timer_wheel_advance(&limiter->expiry, now_ms, on_bucket_idle, limiter);
+
+    unsigned int capacity = (unsigned int)limiter->burst * TOKEN_SCALE;
+    int index = limiter->heads[ip_hash(ip)];
+    while (index != NO_ENTRY && limiter->entries[index].ip != ip) {
+        index = limiter->entries[index].next;
+    }
+
+    RateLimitEntry* entry;
+    if (index == NO_ENTRY) {
+        // Table full: too many distinct clients inside one refill window
+        if (limiter->free_head == NO_ENTRY) return RATE_LIMIT_FULL;
+
+        index = limiter->free_head;
+        entry = &limiter->entries[index];
+        limiter->free_head = entry->next;
+
+        unsigned int bucket = ip_hash(ip);
+        entry->ip = ip;
+        entry->tokens = capacity;
+        entry->last_ms = now_ms;
+        entry->timer.prev = entry->timer.next = NULL;
+        entry->next = limiter->heads[bucket];
+        limiter->heads[bucket] = index;
+        limiter->active++;
+    } else {
+        entry = &limiter->entries[index];
+        unsigned long long refill = (now_ms - entry->last_ms) * (unsigned long long)limiter->rate_per_sec;
+        entry->tokens = refill >= capacity - entry->tokens ? capacity : entry->tokens + (unsigned int)refill;
+        entry->last_ms = now_ms;
+    }
+
+    // A bucket left alone this long is full again and can be forgotten
+    unsigned long long refill_ms = (unsigned long long)(capacity - entry->tokens + TOKEN_SCALE)
+                                   / (unsigned long long)limiter->rate_per_sec + 1;
+    timer_schedule(&limiter->expiry, &entry->timer, now_ms + refill_ms);
+
+    if (entry->tokens < TOKEN_SCALE) {
+        unsigned int missing = TOKEN_SCALE - entry->tokens;
+        unsigned int wait_ms = missing / (unsigned int)limiter->rate_per_sec + 1;
+        return (int)((wait_ms + 999) / 1000);
+    }
+
+    entry->tokens -= TOKEN_SCALE;
+    return 0;
+}
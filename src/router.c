@@ -0,0 +1,274 @@
+/**
+ * router.c - Request routing and query-string parsing
+ * Builds a collision-free route table at startup and parses request lines
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include "../include/pokemon.h"
+
+/**
+ * FNV-1a hash of a path, mixed with a per-table seed
+ */
+static unsigned int route_hash(const char* path, size_t len, unsigned int seed) {
+    unsigned int h = 2166136261u ^ seed;
+    for (size_t i = 0; i < len; i++) {
+        h ^= (unsigned char)path[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+/**
+ * Convert a method token to its enum value
+ */
+static HttpMethod parse_method(const char* token, size_t len) {
+    if (len == 3 && memcmp(token, "GET", 3) == 0) return HTTP_GET;
+    if (len == 4 && memcmp(token, "POST", 4) == 0) return HTTP_POST;
+    if (len == 7 && memcmp(token, "OPTIONS", 7) == 0) return HTTP_OPTIONS;
+    return HTTP_METHOD_UNKNOWN;
+}
+
+/**
+ * Place every route with the given seed. With probe == false any collision
+ * fails; otherwise colliding paths move to the next free slot
+ * Returns 1 if every route was placed
+ */
+static int place_routes(Router* router, const Route* routes, int count, unsigned int seed, bool probe) {
+    memset(router->slots, 0, sizeof(RouteSlot) * (router->mask + 1));
+    router->seed = seed;
+
+    for (int i = 0; i < count; i++) {
+        size_t len = strlen(routes[i].path);
+        unsigned int slot = route_hash(routes[i].path, len, seed) & router->mask;
+        RouteSlot* s = &router->slots[slot];
+
+        while (s->path != NULL &&
+               (s->path_len != len || memcmp(s->path, routes[i].path, len) != 0)) {
+            if (!probe) return 0;
+            slot = (slot + 1) & router->mask;
+            s = &router->slots[slot];
+        }
+
+        s->path = routes[i].path;
+        s->path_len = len;
+        s->handlers[routes[i].method] = routes[i].handler;
+        s->allowed |= 1u << routes[i].method;
+    }
+    return 1;
+}
+
+/**
+ * Build the route table, sized from the route count. Searches for a hash
+ * seed under which every distinct path lands in its own slot, so lookups
+ * never probe; if none exists, falls back to linear probing.
+ * Returns 1 on success, 0 on allocation failure
+ */
+int router_build(Router* router, const Route* routes, int count) {
+    unsigned int slots = ROUTER_MIN_SLOTS;
+    while (slots < (unsigned int)count * ROUTER_LOAD_FACTOR) slots <<= 1;
+
+    RouteSlot* table = realloc(router->slots, sizeof(RouteSlot) * slots);
+    if (!table) return 0;
+    router->slots = table;
+    router->mask = slots - 1;
+
+    for (unsigned int seed = 0; seed < 4096; seed++) {
+        if (place_routes(router, routes, count, seed, false)) {
+            router->perfect = true;
+            return 1;
+        }
+    }
+
+    router->perfect = false;
+    return place_routes(router, routes, count, 0, true);
+}
+
+/**
+ * Look up the handler for a method and path (one hash, one compare when
+ * the table is perfect). Sets *allowed to the bitmask of methods
+ * registered for the path, or 0 if the path is unknown
+ */
+RouteHandler router_lookup(const Router* router, HttpMethod method,
+                           const char* path, size_t path_len, unsigned int* allowed) {
+    unsigned int slot = route_hash(path, path_len, router->seed) & router->mask;
+    const RouteSlot* s = &router->slots[slot];
+
+    while (s->path != NULL && (s->path_len != path_len || memcmp(s->path, path, path_len) != 0)) {
+        if (router->perfect) {
+            s = NULL;
+            break;
+        }
+        slot = (slot + 1) & router->mask;
+        s = &router->slots[slot];
+    }
+
+    if (s == NULL || s->path == NULL) {
+        *allowed = 0;
+        return NULL;
+    }
+
+    *allowed = s->allowed;
+    if (method == HTTP_METHOD_UNKNOWN) return NULL;
+    return s->handlers[method];
+}
+
+/**
+ * Split a query string into key/value slices that point into the request
+ * buffer. Nothing is copied or decoded here
+ */
+static void parse_query(const char* query, size_t len, QueryString* out) {
+    out->count = 0;
+
+    size_t i = 0;
+    while (i < len && out->count < MAX_QUERY_PARAMS) {
+        QueryParam* param = &out->params[out->count];
+        param->key = query + i;
+        param->value = NULL;
+        param->value_len = 0;
+
+        size_t start = i;
+        while (i < len && query[i] != '&' && query[i] != '=') i++;
+        param->key_len = i - start;
+
+        if (i < len && query[i] == '=') {
+            i++;
+            param->value = query + i;
+            start = i;
+            while (i < len && query[i] != '&') i++;
+            param->value_len = i - start;
+        }
+
+        if (param->key_len > 0) out->count++;
+        if (i < len) i++;  // Skip the '&'
+    }
+}
+
+/**
+ * Parse the request line ("METHOD /path?query HTTP/1.1") in a single pass.
+ * Returns 1 on success, 0 if the line is malformed
+ */
+int parse_request_line(const char* request, HttpRequest* out) {
+    const char* p = request;
+
+    const char* method = p;
+    while (*p && *p != ' ' && *p != '\r' && *p != '\n') p++;
+    if (*p != ' ') return 0;
+    out->method = parse_method(method, (size_t)(p - method));
+    p++;
+
+    out->path = p;
+    while (*p && *p != ' ' && *p != '?' && *p != '\r' && *p != '\n') p++;
+    out->path_len = (size_t)(p - out->path);
+    if (out->path_len == 0 || out->path[0] != '/') return 0;
+
+    out->query.count = 0;
+    if (*p == '?') {
+        p++;
+        const char* query = p;
+        while (*p && *p != ' ' && *p != '\r' && *p != '\n') p++;
+        parse_query(query, (size_t)(p - query), &out->query);
+    }
+
+    return 1;
+}
+
+/**
+ * Find a query parameter by name. Returns NULL if absent
+ */
+const QueryParam* query_get(const QueryString* query, const char* key) {
+    size_t key_len = strlen(key);
+    for (int i = 0; i < query->count; i++) {
+        const QueryParam* param = &query->params[i];
+        if (param->key_len == key_len && memcmp(param->key, key, key_len) == 0) {
+            return param;
+        }
+    }
+    return NULL;
+}
+
+static int hex_value(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+/**
+ * Percent-decode a parameter value into buffer ('+' becomes a space).
+ * Returns the decoded length, or -1 if the value is malformed or too long
+ */
+int query_decode(const QueryParam* param, char* buffer, size_t size) {
+    size_t j = 0;
+    for (size_t i = 0; i < param->value_len; i++) {
+        char c = param->value[i];
+
+        if (c == '+') {
+            c = ' ';
+        } else if (c == '%') {
+            if (i + 2 >= param->value_len) return -1;
+            int hi = hex_value(param->value[i + 1]);
+            int lo = hex_value(param->value[i + 2]);
+            if (hi < 0 || lo < 0) return -1;
+            c = (char)(hi * 16 + lo);
+            i += 2;
+        }
+
+        if (j + 1 >= size) return -1;
+        buffer[j++] = c;
+    }
+
+    buffer[j] = '\0';
+    return (int)j;
+}
+
+/**
+ * Read an integer parameter. Returns 1 and stores the value on success,
+ * 0 if the parameter is missing or not a number
+ */
+int query_get_int(const QueryString* query, const char* key, int* value) {
+    const QueryParam* param = query_get(query, key);
+    if (!param) return 0;
+
+    char digits[16];
+    if (query_decode(param, digits, sizeof(digits)) <= 0) return 0;
+
+    char* end;
+    long parsed = strtol(digits, &end, 10);
+    if (*end != '\0' || parsed < -2147483647L || parsed > 2147483647L) return 0;
+
+    *value = (int)parsed;
+    return 1;
+}
+
+/**
+ * Find a header by case-insensitive name within the header block.
+ * Returns a pointer to its (whitespace-trimmed) value, or NULL if absent
+ */
+const char* find_header(const char* headers, size_t len, const char* name, size_t* value_len) {
+    size_t name_len = strlen(name);
+    const char* end = headers + len;
+
+    // Skip the request line
+    const char* line = memchr(headers, '\n', len);
+    while (line && ++line < end) {
+        const char* eol = memchr(line, '\n', (size_t)(end - line));
+        if (!eol) eol = end;
+
+        if ((size_t)(eol - line) > name_len && line[name_len] == ':' &&
+            strncasecmp(line, name, name_len) == 0) {
+            const char* value = line + name_len + 1;
+            const char* value_end = eol;
+            while (value < value_end && (*value == ' ' || *value == '\t')) value++;
+            while (value_end > value && (value_end[-1] == '\r' || value_end[-1] == ' ')) value_end--;
+            *value_len = (size_t)(value_end - value);
+            return value;
+        }
+
+        line = eol < end ? eol : NULL;
+    }
+
+    return NULL;
+}
@@ -3,7 +3,6 @@
  * Implements BST operations and search functions
  */
 
-#include <stdlib.h>
 #include <string.h>
 #include <strings.h>
 #include "../include/pokemon.h"
@@ -12,7 +11,7 @@
  * Search for a Pokemon by ID (O(1) lookup)
  */
 Pokemon* search_by_id(PokedexData* pokedex, int id) {
-    if (id < 1 || id > 151) {
+    if (id < 1 || id > pokedex->count) {
         return NULL;
     }
     return &pokedex->pokemon_array[id - 1];
@@ -24,7 +23,7 @@ Pokemon* search_by_id(PokedexData* pokedex, int id) {
 static BSTNode* bst_search(BSTNode* root, const char* name) {
     if (root == NULL) return NULL;
     
-    int cmp = strcasecmp(name, root->pokemon->name);
+    int cmp = strcasecmp(name, root->name);
     
     if (cmp == 0) {
         return root;
@@ -44,34 +43,26 @@ Pokemon* search_by_name(PokedexData* pokedex, const char* name) {
 }
 
 /**
- * Insert a Pokemon into the BST (sorted by name)
+ * Insert a Pokemon into the BST (sorted by name). Nodes come from the arena
  */
-BSTNode* bst_insert(BSTNode* root, Pokemon* pokemon) {
+BSTNode* bst_insert(Arena* arena, BSTNode* root, Pokemon* pokemon, const char* name) {
     if (root == NULL) {
-        BSTNode* new_node = (BSTNode*)malloc(sizeof(BSTNode));
+        BSTNode* new_node = (BSTNode*)arena_alloc(arena, sizeof(BSTNode));
+        if (new_node == NULL) return NULL;
+        new_node->name = name;
         new_node->pokemon = pokemon;
         new_node->left = NULL;
         new_node->right = NULL;
         return new_node;
     }
     
-    int cmp = strcasecmp(pokemon->name, root->pokemon->name);
+    int cmp = strcasecmp(name, root->name);
     
     if (cmp < 0) {
-        root->left = bst_insert(root->left, pokemon);
+        root->left = bst_insert(arena, root->left, pokemon, name);
     } else if (cmp > 0) {
-        root->right = bst_insert(root->right, pokemon);
+        root->right = bst_insert(arena, root->right, pokemon, name);
     }
     
     return root;
 }
-
-/**
- * Destroy BST and free all nodes
- */
-void bst_destroy(BSTNode* root) {
-    if (root == NULL) return;
-    bst_destroy(root->left);
-    bst_destroy(root->right);
-    free(root);
-}
@@ -0,0 +1,1179 @@
+/**
+ * server.c - Connection event loop
+ * Accepts clients, applies admission control, enforces per-connection
+ * deadlines and dispatches requests. Connection handling is shared by two
+ * backends: a poll() readiness loop everywhere, and an io_uring completion
+ * loop when built with HAVE_IO_URING and the kernel allows it
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include "../include/pokemon.h"
+
+#ifdef _WIN32
+    #include <winsock2.h>
+    #include <ws2tcpip.h>
+    typedef int socklen_t;
+    #define poll WSAPoll
+    #define SEND_FLAGS 0
+    #define CANNED_SEND_FLAGS 0
+#else
+    #include <sys/socket.h>
+    #include <netinet/in.h>
+    #include <arpa/inet.h>
+    #include <unistd.h>
+    #include <errno.h>
+    #include <fcntl.h>
+    #include <poll.h>
+    #include <signal.h>
+    #include <time.h>
+    #define closesocket close
+    #define SEND_FLAGS MSG_NOSIGNAL
+    #define CANNED_SEND_FLAGS (MSG_NOSIGNAL | MSG_DONTWAIT)
+#endif
+
+#ifdef HAVE_IO_URING
+    #include <stdint.h>
+    #include <sys/uio.h>
+    #include <linux/io_uring.h>
+#endif
+
+#define REQUEST_BUFFER_SIZE 8192
+#define DEADLINE_RESOLUTION_MS 100
+
+// Fixed poll entries ahead of the connections
+#define POLL_LISTENER 0
+#define POLL_SIGNAL 1
+#define POLL_HANDOFF 2
+#define FIXED_POLL_ENTRIES 3
+
+// io_uring completions carry the operation, the connection slot and its
+// generation, so completions for a closed and reused slot are ignored
+#define URING_QUEUE_DEPTH 1024
+#define URING_DATA(op, index, generation) \
+    (((unsigned long long)(op) << 48) | ((unsigned long long)((generation) & 0xFFFF) << 32) | (unsigned int)(index))
+#define URING_OP(data) ((int)((data) >> 48))
+#define URING_GENERATION(data) ((unsigned int)(((data) >> 32) & 0xFFFF))
+#define URING_INDEX(data) ((int)((data) & 0xFFFFFFFF))
+
+typedef enum {
+    URING_NOP,                      // Unused SQEs are zeroed into no-ops
+    URING_ACCEPT,
+    URING_FILES_UPDATE,
+    URING_READ,
+    URING_SEND,
+    URING_SIGNAL,
+    URING_HANDOFF,
+    URING_TICK,
+    URING_CANCEL,
+    URING_PERSIST_WRITE,
+    URING_PERSIST_SYNC
+} UringOp;
+
+typedef enum {
+    CONN_READ_HEADERS,
+    CONN_READ_BODY,
+    CONN_WRITING,
+    CONN_IDLE                       // Keep-alive, waiting for the next request
+} ConnState;
+
+typedef struct {
+    TimerNode deadline;             // Must stay first
+    int sock;                       // -1 when the slot is free
+    int poll_index;
+    unsigned int generation;        // Bumped on close (io_uring backend)
+    unsigned int ip;
+    ConnState state;
+    size_t received;
+    size_t request_len;             // Headers + body of the current request
+    size_t sent;
+    int idle_prev;                  // Idle list links, valid while CONN_IDLE
+    int idle_next;
+    unsigned long long request_start_us;
+    AccessLogRecord log;            // Filled at dispatch, submitted once the reply is sent
+    ResponseBuffer out;
+    char buffer[REQUEST_BUFFER_SIZE];
+} Connection;
+
+typedef struct {
+    const ServerConfig* config;
+    PokedexData* pokedex;
+    UserProgress* progress;
+    int server_sock;
+    Connection* conns;
+    int max_conns;
+    int* free_slots;
+    int free_count;
+    struct pollfd* fds;             // Fixed entries first, then connections
+    int* poll_owner;                // Connection index for each fds entry
+    int nfds;
+    TimerWheel deadlines;
+    int idle_head;                  // Idle keep-alive connections, oldest first, -1 = none
+    int idle_tail;
+    bool draining;                  // Not accepting; exit once connections finish
+    unsigned long long drain_deadline_ms;   // Close whatever is still open at this time
+    int handoff_peer;               // Replacement process waiting for the socket, or -1
+    #ifdef HAVE_IO_URING
+    IoRing* ring;                   // NULL when running the poll backend
+    bool fixed_buffers;             // Connection buffers registered for READ_FIXED
+    bool tick_armed;
+    struct __kernel_timespec tick;
+    int persist_fd;                 // Progress file, fixed file slot max_conns
+    bool persist_inflight;
+    bool persist_dirty;             // Progress changed while a write was in flight
+    char* persist_buf;              // Registered staging copy of the persisted bytes
+    #endif
+} Server;
+
+// Canned replies, sent before any parsing when a client is turned away
+static const char overload_response[] =
+    "HTTP/1.1 503 Service Unavailable\r\n"
+    "Content-Type: text/plain\r\n"
+    "Content-Length: 19\r\n"
+    "Retry-After: 1\r\n"
+    "Connection: close\r\n"
+    "\r\n"
+    "Service Unavailable";
+
+static const char too_large_response[] =
+    "HTTP/1.1 413 Payload Too Large\r\n"
+    "Content-Type: text/plain\r\n"
+    "Content-Length: 0\r\n"
+    "Connection: close\r\n"
+    "\r\n";
+
+static const char timeout_response[] =
+    "HTTP/1.1 408 Request Timeout\r\n"
+    "Content-Type: text/plain\r\n"
+    "Content-Length: 0\r\n"
+    "Connection: close\r\n"
+    "\r\n";
+
+static RateLimiter limiter;
+
+#ifndef _WIN32
+// Self-pipe so a signal always wakes poll()
+static int signal_pipe[2] = { -1, -1 };
+
+static void on_shutdown_signal(int sig) {
+    (void)sig;
+    char byte = 'T';
+    ssize_t written = write(signal_pipe[1], &byte, 1);    // Full pipe: wakeup already pending
+    (void)written;
+}
+#endif
+
+/**
+ * Monotonic clock in microseconds
+ */
+static unsigned long long now_us(void) {
+    #ifdef _WIN32
+    return (unsigned long long)GetTickCount64() * 1000ULL;
+    #else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000ULL + (unsigned long long)ts.tv_nsec / 1000ULL;
+    #endif
+}
+
+/**
+ * Monotonic clock in milliseconds
+ */
+static unsigned long long now_ms(void) {
+    return now_us() / 1000ULL;
+}
+
+/**
+ * Wall clock in milliseconds since the epoch, for log timestamps
+ */
+static unsigned long long wall_ms(void) {
+    #ifdef _WIN32
+    return (unsigned long long)time(NULL) * 1000ULL;
+    #else
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (unsigned long long)ts.tv_sec * 1000ULL + (unsigned long long)ts.tv_nsec / 1000000ULL;
+    #endif
+}
+
+static void set_nonblocking(int sock) {
+    #ifdef _WIN32
+    u_long mode = 1;
+    ioctlsocket(sock, FIONBIO, &mode);
+    #else
+    fcntl(sock, F_SETFL, fcntl(sock, F_GETFL, 0) | O_NONBLOCK);
+    #endif
+}
+
+static bool would_block(void) {
+    #ifdef _WIN32
+    return WSAGetLastError() == WSAEWOULDBLOCK;
+    #else
+    return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+    #endif
+}
+
+/**
+ * Best-effort send of a canned reply; the connection is closed right after.
+ * The request was never parsed, so it is logged with method and path "-"
+ */
+static void send_canned(int sock, unsigned int ip, unsigned long long start_us,
+                        const char* response, size_t len) {
+    int sent = send(sock, response, (int)len, CANNED_SEND_FLAGS);
+
+    AccessLogRecord record;
+    record.timestamp_ms = wall_ms();
+    record.ip = ip;
+    record.bytes = sent > 0 ? (unsigned int)sent : 0;
+    record.latency_us = (unsigned int)(now_us() - start_us);
+    record.status = atoi(response + 9);     // "HTTP/1.1 503"
+    strcpy(record.method, "-");
+    strcpy(record.path, "-");
+    access_log_submit(&record);
+}
+
+/**
+ * Reply 429 with the client's Retry-After
+ */
+static void send_rate_limited(int sock, unsigned int ip, int retry_after) {
+    char response[160];
+    int len = snprintf(response, sizeof(response),
+        "HTTP/1.1 429 Too Many Requests\r\n"
+        "Content-Type: text/plain\r\n"
+        "Content-Length: 0\r\n"
+        "Retry-After: %d\r\n"
+        "Connection: close\r\n"
+        "\r\n",
+        retry_after);
+    send_canned(sock, ip, now_us(), response, (size_t)len);
+}
+
+/**
+ * Arm the connection's single deadline for its current state
+ */
+static void set_deadline(Server* server, Connection* conn, int timeout_ms) {
+    timer_schedule(&server->deadlines, &conn->deadline, now_ms() + (unsigned long long)timeout_ms);
+}
+
+#ifdef HAVE_IO_URING
+/**
+ * Queue a read into the free tail of the connection's buffer
+ */
+static void uring_read(Server* server, Connection* conn) {
+    struct io_uring_sqe* sqe = uring_get_sqe(server->ring);
+    if (!sqe) return;   // Queue exhausted: the deadline reclaims the connection
+
+    int index = (int)(conn - server->conns);
+    sqe->opcode = server->fixed_buffers ? IORING_OP_READ_FIXED : IORING_OP_RECV;
+    sqe->fd = index;
+    sqe->flags = IOSQE_FIXED_FILE;
+    sqe->addr = (unsigned long long)(uintptr_t)(conn->buffer + conn->received);
+    sqe->len = (unsigned int)(REQUEST_BUFFER_SIZE - 1 - conn->received);
+    sqe->buf_index = 0;
+    sqe->user_data = URING_DATA(URING_READ, index, conn->generation);
+}
+
+/**
+ * Queue a send of the unsent part of the response
+ */
+static void uring_send(Server* server, Connection* conn) {
+    struct io_uring_sqe* sqe = uring_get_sqe(server->ring);
+    if (!sqe) return;
+
+    int index = (int)(conn - server->conns);
+    sqe->opcode = IORING_OP_SEND;
+    sqe->fd = index;
+    sqe->flags = IOSQE_FIXED_FILE;
+    sqe->addr = (unsigned long long)(uintptr_t)(conn->out.data + conn->sent);
+    sqe->len = (unsigned int)(conn->out.len - conn->sent);
+    sqe->msg_flags = MSG_NOSIGNAL;
+    sqe->user_data = URING_DATA(URING_SEND, index, conn->generation);
+}
+#endif
+
+/**
+ * Ask the backend for more request bytes
+ */
+static void want_read(Server* server, Connection* conn) {
+    #ifdef HAVE_IO_URING
+    if (server->ring) {
+        uring_read(server, conn);
+        return;
+    }
+    #endif
+    server->fds[conn->poll_index].events = POLLIN;
+}
+
+/**
+ * Ask the backend to send the rest of the response
+ */
+static void want_write(Server* server, Connection* conn) {
+    #ifdef HAVE_IO_URING
+    if (server->ring) {
+        uring_send(server, conn);
+        return;
+    }
+    #endif
+    server->fds[conn->poll_index].events = POLLOUT;
+}
+
+/**
+ * Idle keep-alive connections are kept in a list, oldest first, so the
+ * connection cap can reclaim the longest-idle slot
+ */
+static void idle_push(Server* server, Connection* conn) {
+    int index = (int)(conn - server->conns);
+    conn->idle_prev = server->idle_tail;
+    conn->idle_next = -1;
+    if (server->idle_tail >= 0) server->conns[server->idle_tail].idle_next = index;
+    else server->idle_head = index;
+    server->idle_tail = index;
+}
+
+static void idle_remove(Server* server, Connection* conn) {
+    if (conn->idle_prev >= 0) server->conns[conn->idle_prev].idle_next = conn->idle_next;
+    else server->idle_head = conn->idle_next;
+    if (conn->idle_next >= 0) server->conns[conn->idle_next].idle_prev = conn->idle_prev;
+    else server->idle_tail = conn->idle_prev;
+}
+
+static void close_connection(Server* server, Connection* conn) {
+    int index = (int)(conn - server->conns);
+
+    timer_cancel(&server->deadlines, &conn->deadline);
+    if (conn->state == CONN_IDLE) idle_remove(server, conn);
+
+    #ifdef HAVE_IO_URING
+    if (server->ring) {
+        // Shutdown completes any read or send still queued on the socket. Its
+        // fixed file slot is simply overwritten when the slot is reused
+        shutdown(conn->sock, SHUT_RDWR);
+        closesocket(conn->sock);
+        conn->sock = -1;
+        conn->generation++;
+        server->free_slots[server->free_count++] = index;
+        return;
+    }
+    #endif
+
+    closesocket(conn->sock);
+    conn->sock = -1;
+
+    // Swap the last poll entry into the hole
+    int last = --server->nfds;
+    if (conn->poll_index != last) {
+        server->fds[conn->poll_index] = server->fds[last];
+        server->poll_owner[conn->poll_index] = server->poll_owner[last];
+        server->conns[server->poll_owner[last]].poll_index = conn->poll_index;
+    }
+
+    server->free_slots[server->free_count++] = index;
+}
+
+/**
+ * Deadline callback: the connection took too long in its current state
+ */
+static void on_deadline(TimerNode* node, void* ctx) {
+    Server* server = (Server*)ctx;
+    Connection* conn = (Connection*)node;
+
+    if (conn->state == CONN_READ_HEADERS || conn->state == CONN_READ_BODY) {
+        send_canned(conn->sock, conn->ip, conn->request_start_us,
+                    timeout_response, sizeof(timeout_response) - 1);
+    }
+    close_connection(server, conn);
+}
+
+/**
+ * Take on an accepted client. At the connection cap the longest-idle
+ * keep-alive connection gives up its slot; with none idle, or no rate
+ * bucket free, the client gets a canned 503. Clients over their rate get
+ * a 429. Either way they are closed immediately
+ */
+static void admit_client(Server* server, int client_sock, unsigned int ip) {
+    if (server->free_count == 0 && server->idle_head < 0) {
+        send_canned(client_sock, ip, now_us(), overload_response, sizeof(overload_response) - 1);
+        closesocket(client_sock);
+        return;
+    }
+
+    int retry_after = ratelimit_check(&limiter, ip, now_ms());
+    if (retry_after == RATE_LIMIT_FULL) {
+        send_canned(client_sock, ip, now_us(), overload_response, sizeof(overload_response) - 1);
+        closesocket(client_sock);
+        return;
+    }
+    if (retry_after > 0) {
+        send_rate_limited(client_sock, ip, retry_after);
+        closesocket(client_sock);
+        return;
+    }
+
+    if (server->free_count == 0) {
+        close_connection(server, &server->conns[server->idle_head]);
+    }
+
+    int index = server->free_slots[--server->free_count];
+    Connection* conn = &server->conns[index];
+    conn->sock = client_sock;
+    conn->ip = ip;
+    conn->state = CONN_READ_HEADERS;
+    conn->received = 0;
+    conn->request_start_us = now_us();
+    conn->deadline.prev = conn->deadline.next = NULL;
+    set_deadline(server, conn, server->config->header_timeout_ms);
+
+    #ifdef HAVE_IO_URING
+    if (server->ring) {
+        // Install the socket in the connection's fixed file slot, then read
+        struct io_uring_sqe* sqe = uring_get_sqe(server->ring);
+        if (!sqe) {
+            close_connection(server, conn);
+            return;
+        }
+        sqe->opcode = IORING_OP_FILES_UPDATE;
+        sqe->fd = -1;
+        sqe->addr = (unsigned long long)(uintptr_t)&conn->sock;
+        sqe->len = 1;
+        sqe->off = (unsigned long long)index;
+        sqe->flags = IOSQE_IO_LINK;
+        sqe->user_data = URING_DATA(URING_FILES_UPDATE, index, conn->generation);
+        uring_read(server, conn);
+        return;
+    }
+    #endif
+
+    set_nonblocking(client_sock);
+
+    conn->poll_index = server->nfds;
+    server->fds[server->nfds].fd = client_sock;
+    server->fds[server->nfds].events = POLLIN;
+    server->fds[server->nfds].revents = 0;
+    server->poll_owner[server->nfds++] = index;
+}
+
+/**
+ * Accept every pending client (poll backend)
+ */
+static void accept_clients(Server* server) {
+    while (1) {
+        struct sockaddr_in client_addr;
+        socklen_t addr_len = sizeof(client_addr);
+        int client_sock = accept(server->server_sock, (struct sockaddr*)&client_addr, &addr_len);
+        if (client_sock < 0) return;
+
+        admit_client(server, client_sock, ntohl(client_addr.sin_addr.s_addr));
+    }
+}
+
+/**
+ * HTTP/1.1 keeps the connection open unless the client asks otherwise;
+ * HTTP/1.0 closes it unless the client asks for keep-alive
+ */
+static bool wants_keep_alive(const Connection* conn, size_t header_len) {
+    const char* eol = memchr(conn->buffer, '\r', header_len);
+    bool http10 = eol && eol - conn->buffer >= 8 && memcmp(eol - 8, "HTTP/1.0", 8) == 0;
+
+    size_t len;
+    const char* value = find_header(conn->buffer, header_len, "Connection", &len);
+    if (value && len == 5 && strncasecmp(value, "close", 5) == 0) return false;
+    if (value && len == 10 && strncasecmp(value, "keep-alive", 10) == 0) return true;
+    return !http10;
+}
+
+/**
+ * Copy the request's method and target into the connection's log record
+ */
+static void capture_request_line(Connection* conn) {
+    AccessLogRecord* log = &conn->log;
+    size_t line_len = strcspn(conn->buffer, "\r\n");
+    size_t method_len = strcspn(conn->buffer, " ");
+    if (method_len > line_len) method_len = line_len;
+    if (method_len >= sizeof(log->method)) method_len = sizeof(log->method) - 1;
+    memcpy(log->method, conn->buffer, method_len);
+    log->method[method_len] = '\0';
+
+    const char* target = conn->buffer + method_len + (method_len < line_len);
+    size_t target_len = strcspn(target, " \r\n");
+    if (target_len >= sizeof(log->path)) target_len = sizeof(log->path) - 1;
+    memcpy(log->path, target, target_len);
+    log->path[target_len] = '\0';
+}
+
+/**
+ * Hand the finished request to the access log; never blocks
+ */
+static void log_request(Connection* conn) {
+    conn->log.ip = conn->ip;
+    conn->log.bytes = (unsigned int)conn->sent;
+    conn->log.latency_us = (unsigned int)(now_us() - conn->request_start_us);
+    conn->log.timestamp_ms = wall_ms();
+    access_log_submit(&conn->log);
+}
+
+/**
+ * Dispatch the complete request in the buffer and start writing the reply
+ */
+static void dispatch(Server* server, Connection* conn, size_t header_len) {
+    char saved = conn->buffer[conn->request_len];
+    conn->buffer[conn->request_len] = '\0';
+
+    conn->out.len = 0;
+    conn->out.keep_alive = !server->draining && wants_keep_alive(conn, header_len);
+    handle_request(&conn->out, conn->buffer, server->pokedex, server->progress);
+    capture_request_line(conn);
+    conn->log.status = conn->out.len > 12 ? atoi(conn->out.data + 9) : 0;   // "HTTP/1.1 200"
+
+    conn->buffer[conn->request_len] = saved;
+    conn->state = CONN_WRITING;
+    conn->sent = 0;
+    set_deadline(server, conn, server->config->write_timeout_ms);
+    want_write(server, conn);
+}
+
+/**
+ * Act on whatever request bytes are buffered
+ */
+static void process_input(Server* server, Connection* conn) {
+    conn->buffer[conn->received] = '\0';
+    char* end = strstr(conn->buffer, "\r\n\r\n");
+
+    if (!end) {
+        if (conn->received == REQUEST_BUFFER_SIZE - 1) {
+            send_canned(conn->sock, conn->ip, conn->request_start_us,
+                        too_large_response, sizeof(too_large_response) - 1);
+            close_connection(server, conn);
+        }
+        return;
+    }
+
+    size_t header_len = (size_t)(end - conn->buffer) + 4;
+    size_t body_len = 0;
+    size_t value_len;
+    const char* length = find_header(conn->buffer, header_len, "Content-Length", &value_len);
+    if (length) body_len = strtoul(length, NULL, 10);
+
+    if (body_len > REQUEST_BUFFER_SIZE - 1 - header_len) {
+        send_canned(conn->sock, conn->ip, conn->request_start_us,
+                    too_large_response, sizeof(too_large_response) - 1);
+        close_connection(server, conn);
+        return;
+    }
+
+    conn->request_len = header_len + body_len;
+    if (conn->received < conn->request_len) {
+        if (conn->state != CONN_READ_BODY) {
+            conn->state = CONN_READ_BODY;
+            set_deadline(server, conn, server->config->body_timeout_ms);
+        }
+        return;
+    }
+
+    dispatch(server, conn, header_len);
+}
+
+/**
+ * Parse what is buffered and ask for more if the request is incomplete
+ */
+static void read_request(Server* server, Connection* conn) {
+    process_input(server, conn);
+    if (conn->sock >= 0 && (conn->state == CONN_READ_HEADERS || conn->state == CONN_READ_BODY)) {
+        want_read(server, conn);
+    }
+}
+
+/**
+ * Begin the next request on a kept-alive connection, idle or pipelined.
+ * Each one spends a token before it is parsed; returns false if the
+ * client was over its rate (429) or no bucket was free (503) and it has
+ * been closed
+ */
+static bool start_request(Server* server, Connection* conn) {
+    int retry_after = ratelimit_check(&limiter, conn->ip, now_ms());
+    if (retry_after == RATE_LIMIT_FULL) {
+        send_canned(conn->sock, conn->ip, now_us(), overload_response, sizeof(overload_response) - 1);
+        close_connection(server, conn);
+        return false;
+    }
+    if (retry_after > 0) {
+        send_rate_limited(conn->sock, conn->ip, retry_after);
+        close_connection(server, conn);
+        return false;
+    }
+    if (conn->state == CONN_IDLE) idle_remove(server, conn);
+    conn->state = CONN_READ_HEADERS;
+    conn->request_start_us = now_us();
+    set_deadline(server, conn, server->config->header_timeout_ms);
+    return true;
+}
+
+/**
+ * Request bytes arrived; received <= 0 means the peer closed or failed
+ */
+static void on_received(Server* server, Connection* conn, int received) {
+    if (received <= 0) {
+        close_connection(server, conn);
+        return;
+    }
+
+    if (conn->state == CONN_IDLE && !start_request(server, conn)) return;
+
+    conn->received += (size_t)received;
+    read_request(server, conn);
+}
+
+/**
+ * The whole response is out: log it, then close or go idle
+ */
+static void finish_response(Server* server, Connection* conn) {
+    log_request(conn);
+
+    if (!conn->out.keep_alive || server->draining) {
+        close_connection(server, conn);
+        return;
+    }
+
+    // Keep any pipelined bytes that followed the request
+    conn->received -= conn->request_len;
+    memmove(conn->buffer, conn->buffer + conn->request_len, conn->received);
+
+    if (conn->received > 0) {
+        if (start_request(server, conn)) read_request(server, conn);
+    } else {
+        conn->state = CONN_IDLE;
+        idle_push(server, conn);
+        set_deadline(server, conn, server->config->idle_timeout_ms);
+        want_read(server, conn);
+    }
+}
+
+/**
+ * Socket is readable: pull in what is available (poll backend)
+ */
+static void on_readable(Server* server, Connection* conn) {
+    size_t space = REQUEST_BUFFER_SIZE - 1 - conn->received;
+    int received = recv(conn->sock, conn->buffer + conn->received, (int)space, 0);
+    if (received < 0 && would_block()) return;
+    on_received(server, conn, received);
+}
+
+/**
+ * Socket is writable: drain the response (poll backend)
+ */
+static void on_writable(Server* server, Connection* conn) {
+    while (conn->sent < conn->out.len) {
+        int sent = send(conn->sock, conn->out.data + conn->sent,
+                        (int)(conn->out.len - conn->sent), SEND_FLAGS);
+        if (sent < 0 && would_block()) return;
+        if (sent <= 0) {
+            close_connection(server, conn);
+            return;
+        }
+        conn->sent += (size_t)sent;
+    }
+
+    finish_response(server, conn);
+}
+
+/**
+ * Stop accepting and close connections with no request in progress: idle
+ * keep-alive ones and those that have not sent a byte yet. The loop exits
+ * once the rest have been answered, hit their deadlines or outlived the
+ * drain timeout
+ */
+static void start_draining(Server* server) {
+    if (server->draining) return;
+    server->draining = true;
+    server->fds[POLL_LISTENER].fd = -1;
+
+    #ifdef HAVE_IO_URING
+    if (server->ring) {
+        struct io_uring_sqe* sqe = uring_get_sqe(server->ring);
+        if (sqe) {
+            sqe->opcode = IORING_OP_ASYNC_CANCEL;
+            sqe->fd = -1;
+            sqe->addr = URING_DATA(URING_ACCEPT, 0, 0);
+            sqe->user_data = URING_DATA(URING_CANCEL, 0, 0);
+        }
+    }
+    #endif
+
+    server->drain_deadline_ms = now_ms() + (unsigned long long)server->config->drain_timeout_ms;
+
+    for (int i = 0; i < server->max_conns; i++) {
+        Connection* conn = &server->conns[i];
+        bool unstarted = conn->state == CONN_READ_HEADERS && conn->received == 0;
+        if (conn->sock >= 0 && (conn->state == CONN_IDLE || unstarted)) {
+            close_connection(server, conn);
+        }
+    }
+
+    printf("Draining %d connection(s)...\n", server->max_conns - server->free_count);
+    fflush(stdout);
+}
+
+/**
+ * Close every connection still open once the drain timeout has passed
+ */
+static void enforce_drain_deadline(Server* server) {
+    if (!server->draining || now_ms() < server->drain_deadline_ms) return;
+
+    for (int i = 0; i < server->max_conns; i++) {
+        if (server->conns[i].sock >= 0) close_connection(server, &server->conns[i]);
+    }
+}
+
+/**
+ * A replacement process connected to the handoff socket: pass it the
+ * listener right away, then drain. The peer stays open until progress
+ * has been flushed, which is all the replacement waits for
+ */
+static void accept_handoff(Server* server) {
+    int peer = accept(server->fds[POLL_HANDOFF].fd, NULL, NULL);
+    if (peer < 0) return;
+
+    if (server->handoff_peer >= 0) {
+        closesocket(peer);
+        return;
+    }
+
+    if (!handoff_send(peer, server->server_sock)) {
+        printf("Handoff failed\n");
+        closesocket(peer);
+        return;
+    }
+
+    printf("Listening socket handed off\n");
+    server->handoff_peer = peer;
+    server->fds[POLL_HANDOFF].fd = -1;
+    start_draining(server);
+}
+
+/**
+ * Create, bind and listen on the server socket
+ * Returns the socket, or -1 on failure
+ */
+int open_listener(const ServerConfig* config) {
+    int server_sock = socket(AF_INET, SOCK_STREAM, 0);
+    if (server_sock < 0) {
+        printf("Socket creation failed\n");
+        return -1;
+    }
+
+    int opt = 1;
+    setsockopt(server_sock, SOL_SOCKET, SO_REUSEADDR, (char*)&opt, sizeof(opt));
+
+    struct sockaddr_in server_addr;
+    memset(&server_addr, 0, sizeof(server_addr));
+    server_addr.sin_family = AF_INET;
+    server_addr.sin_addr.s_addr = INADDR_ANY;
+    server_addr.sin_port = htons((unsigned short)config->port);
+
+    if (bind(server_sock, (struct sockaddr*)&server_addr, sizeof(server_addr)) < 0) {
+        printf("Bind failed\n");
+        closesocket(server_sock);
+        return -1;
+    }
+
+    listen(server_sock, config->backlog);
+    return server_sock;
+}
+
+/**
+ * Readiness loop over poll(); runs until draining has finished
+ */
+static void poll_loop(Server* server) {
+    while (!server->draining || server->nfds > FIXED_POLL_ENTRIES) {
+        // Only wake on a timer tick while some deadline is armed
+        int timeout = server->deadlines.pending > 0 ? DEADLINE_RESOLUTION_MS : -1;
+        int ready = poll(server->fds, (unsigned long)server->nfds, timeout);
+
+        timer_wheel_advance(&server->deadlines, now_ms(), on_deadline, server);
+        enforce_drain_deadline(server);
+        if (ready <= 0) continue;
+
+        // Walk backwards so swap-removal only moves entries already visited
+        for (int k = server->nfds - 1; k >= FIXED_POLL_ENTRIES; k--) {
+            short revents = server->fds[k].revents;
+            if (revents == 0) continue;
+            server->fds[k].revents = 0;
+
+            Connection* conn = &server->conns[server->poll_owner[k]];
+            if (conn->state == CONN_WRITING) {
+                on_writable(server, conn);
+            } else {
+                on_readable(server, conn);
+            }
+        }
+
+        #ifndef _WIN32
+        if (server->fds[POLL_SIGNAL].revents & POLLIN) {
+            char drain[16];
+            while (read(signal_pipe[0], drain, sizeof(drain)) > 0) {}
+            start_draining(server);
+        }
+        #endif
+
+        if (server->fds[POLL_HANDOFF].revents & POLLIN) {
+            accept_handoff(server);
+        }
+
+        if (server->fds[POLL_LISTENER].revents & POLLIN) {
+            accept_clients(server);
+        }
+    }
+}
+
+#ifdef HAVE_IO_URING
+// The loop whose progress file the asynchronous saver writes to
+static Server* persist_owner;
+
+static void uring_poll_fd(Server* server, int fd, UringOp op) {
+    struct io_uring_sqe* sqe = uring_get_sqe(server->ring);
+    if (!sqe) return;
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = fd;
+    sqe->poll32_events = POLLIN;
+    sqe->user_data = URING_DATA(op, 0, 0);
+}
+
+static void uring_accept(Server* server) {
+    struct io_uring_sqe* sqe = uring_get_sqe(server->ring);
+    if (!sqe) return;
+    sqe->opcode = IORING_OP_ACCEPT;
+    sqe->fd = server->server_sock;
+    sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+    sqe->accept_flags = SOCK_CLOEXEC;
+    sqe->user_data = URING_DATA(URING_ACCEPT, 0, 0);
+}
+
+/**
+ * One deadline tick from now, so the wheel advances while timers are armed
+ */
+static void uring_tick(Server* server) {
+    struct io_uring_sqe* sqe = uring_get_sqe(server->ring);
+    if (!sqe) return;
+    sqe->opcode = IORING_OP_TIMEOUT;
+    sqe->fd = -1;
+    sqe->addr = (unsigned long long)(uintptr_t)&server->tick;
+    sqe->len = 1;
+    sqe->user_data = URING_DATA(URING_TICK, 0, 0);
+    server->tick_armed = true;
+}
+
+/**
+ * Progress saver for request handlers: queue a write and a linked fsync of
+ * the persisted bytes. Saves requested while one is in flight are
+ * coalesced into a single follow-up write
+ */
+static int uring_save_progress(UserProgress* progress) {
+    Server* server = persist_owner;
+    if (server->persist_inflight) {
+        server->persist_dirty = true;
+        return 1;
+    }
+
+    struct io_uring_sqe* write_sqe = uring_get_sqe(server->ring);
+    struct io_uring_sqe* sync_sqe = write_sqe ? uring_get_sqe(server->ring) : NULL;
+    if (!sync_sqe) return save_user_progress(PROGRESS_FILE, progress);
+
+    memcpy(server->persist_buf, progress, PROGRESS_PERSISTED_SIZE);
+    write_sqe->opcode = server->fixed_buffers ? IORING_OP_WRITE_FIXED : IORING_OP_WRITE;
+    write_sqe->fd = server->max_conns;
+    write_sqe->flags = IOSQE_FIXED_FILE | IOSQE_IO_LINK;
+    write_sqe->addr = (unsigned long long)(uintptr_t)server->persist_buf;
+    write_sqe->len = PROGRESS_PERSISTED_SIZE;
+    write_sqe->buf_index = 1;
+    write_sqe->user_data = URING_DATA(URING_PERSIST_WRITE, 0, 0);
+
+    sync_sqe->opcode = IORING_OP_FSYNC;
+    sync_sqe->fd = server->max_conns;
+    sync_sqe->flags = IOSQE_FIXED_FILE;
+    sync_sqe->fsync_flags = IORING_FSYNC_DATASYNC;
+    sync_sqe->user_data = URING_DATA(URING_PERSIST_SYNC, 0, 0);
+
+    server->persist_inflight = true;
+    return 1;
+}
+
+/**
+ * Route one completion to the connection or loop state it belongs to
+ * Returns false if the ring cannot serve (multishot accept unsupported)
+ */
+static bool on_completion(Server* server, const struct io_uring_cqe* cqe) {
+    int op = URING_OP(cqe->user_data);
+    int res = cqe->res;
+
+    if (op == URING_READ || op == URING_SEND) {
+        Connection* conn = &server->conns[URING_INDEX(cqe->user_data)];
+        if (conn->sock < 0 || (conn->generation & 0xFFFF) != URING_GENERATION(cqe->user_data)) {
+            return true;    // Completion for a connection already closed
+        }
+        if (op == URING_READ) {
+            on_received(server, conn, res);
+        } else if (res <= 0) {
+            close_connection(server, conn);
+        } else {
+            conn->sent += (size_t)res;
+            if (conn->sent < conn->out.len) uring_send(server, conn);
+            else finish_response(server, conn);
+        }
+        return true;
+    }
+
+    switch (op) {
+    case URING_ACCEPT:
+        if (res == -EINVAL && server->free_count == server->max_conns) return false;
+        if (res >= 0) {
+            struct sockaddr_in client_addr;
+            socklen_t addr_len = sizeof(client_addr);
+            unsigned int ip = 0;
+            if (getpeername(res, (struct sockaddr*)&client_addr, &addr_len) == 0) {
+                ip = ntohl(client_addr.sin_addr.s_addr);
+            }
+            admit_client(server, res, ip);
+        }
+        if (!(cqe->flags & IORING_CQE_F_MORE) && !server->draining && res != -EINVAL) {
+            uring_accept(server);
+        }
+        break;
+    case URING_SIGNAL: {
+        char drain[16];
+        while (read(signal_pipe[0], drain, sizeof(drain)) > 0) {}
+        start_draining(server);
+        break;
+    }
+    case URING_HANDOFF:
+        accept_handoff(server);
+        if (server->handoff_peer < 0 && !server->draining) {
+            uring_poll_fd(server, server->fds[POLL_HANDOFF].fd, URING_HANDOFF);
+        }
+        break;
+    case URING_TICK:
+        server->tick_armed = false;
+        break;
+    case URING_PERSIST_WRITE:
+        if (res != (int)PROGRESS_PERSISTED_SIZE) printf("Warning: failed to save progress\n");
+        break;
+    case URING_PERSIST_SYNC:
+        server->persist_inflight = false;
+        if (server->persist_dirty) {
+            server->persist_dirty = false;
+            uring_save_progress(server->progress);
+        }
+        break;
+    default:
+        break;
+    }
+    return true;
+}
+
+/**
+ * Completion loop over io_uring: multishot accept, reads into registered
+ * connection buffers and sends on fixed files, all submitted in one
+ * io_uring_enter per iteration. Returns false without having served
+ * anything if the kernel lacks what the loop needs, so the caller can
+ * fall back to poll()
+ */
+static bool uring_loop(Server* server) {
+    server->ring = uring_create(URING_QUEUE_DEPTH);
+    if (!server->ring) return false;
+
+    // Fixed file slots: one per connection, then the progress file
+    server->persist_fd = open(PROGRESS_FILE, O_WRONLY | O_CREAT | O_CLOEXEC, 0644);
+    server->persist_buf = malloc(PROGRESS_PERSISTED_SIZE);
+    int* files = malloc(sizeof(int) * (size_t)(server->max_conns + 1));
+    bool ready = server->persist_buf && files;
+    if (ready) {
+        for (int i = 0; i < server->max_conns; i++) files[i] = -1;
+        files[server->max_conns] = server->persist_fd;
+        ready = uring_register_files(server->ring, files, (unsigned)server->max_conns + 1);
+    }
+    free(files);
+
+    if (ready) {
+        struct iovec buffers[2] = {
+            { server->conns, sizeof(Connection) * (size_t)server->max_conns },
+            { server->persist_buf, PROGRESS_PERSISTED_SIZE }
+        };
+        server->fixed_buffers = uring_register_buffers(server->ring, buffers, 2);
+
+        // io_uring waits for readiness itself; blocking sockets avoid -EAGAIN
+        fcntl(server->server_sock, F_SETFL, fcntl(server->server_sock, F_GETFL, 0) & ~O_NONBLOCK);
+
+        server->tick.tv_sec = 0;
+        server->tick.tv_nsec = DEADLINE_RESOLUTION_MS * 1000000LL;
+        uring_accept(server);
+        uring_poll_fd(server, signal_pipe[0], URING_SIGNAL);
+        if (server->fds[POLL_HANDOFF].fd >= 0) {
+            uring_poll_fd(server, server->fds[POLL_HANDOFF].fd, URING_HANDOFF);
+        }
+        if (server->persist_fd >= 0) {
+            persist_owner = server;
+            set_progress_saver(uring_save_progress);
+        }
+        printf("Using io_uring backend%s\n", server->fixed_buffers ? " (registered buffers)" : "");
+        fflush(stdout);
+    }
+
+    while (ready && (!server->draining || server->free_count < server->max_conns)) {
+        if (server->deadlines.pending > 0 && !server->tick_armed) {
+            uring_tick(server);
+        }
+        if (uring_submit(server->ring, 1) < 0) {
+            ready = server->free_count < server->max_conns;
+            break;
+        }
+
+        struct io_uring_cqe* cqe;
+        while (ready && (cqe = uring_peek_cqe(server->ring)) != NULL) {
+            struct io_uring_cqe completion = *cqe;
+            uring_cqe_seen(server->ring);
+            ready = on_completion(server, &completion);
+        }
+
+        timer_wheel_advance(&server->deadlines, now_ms(), on_deadline, server);
+        enforce_drain_deadline(server);
+    }
+
+    // Let the last queued progress write land before the final save
+    while (server->persist_inflight && uring_submit(server->ring, 1) >= 0) {
+        struct io_uring_cqe* cqe;
+        while ((cqe = uring_peek_cqe(server->ring)) != NULL) {
+            struct io_uring_cqe completion = *cqe;
+            uring_cqe_seen(server->ring);
+            if (URING_OP(completion.user_data) == URING_PERSIST_SYNC) {
+                server->persist_inflight = false;
+            }
+        }
+    }
+
+    set_progress_saver(NULL);
+    uring_destroy(server->ring);
+    server->ring = NULL;
+    if (server->persist_fd >= 0) close(server->persist_fd);
+    free(server->persist_buf);
+    set_nonblocking(server->server_sock);
+    return ready;
+}
+#endif
+
+/**
+ * Run the event loop on an already listening socket until SIGTERM/SIGINT
+ * or a handoff, then drain, flush progress and release the socket
+ * Returns non-zero on startup failure
+ */
+int run_server(const ServerConfig* config, int server_sock,
+               PokedexData* pokedex, UserProgress* progress) {
+    #ifndef _WIN32
+    signal(SIGPIPE, SIG_IGN);
+    if (pipe(signal_pipe) == 0) {
+        set_nonblocking(signal_pipe[0]);
+        set_nonblocking(signal_pipe[1]);
+        signal(SIGTERM, on_shutdown_signal);
+        signal(SIGINT, on_shutdown_signal);
+    }
+    #endif
+
+    set_nonblocking(server_sock);
+
+    Server server;
+    memset(&server, 0, sizeof(server));
+    server.config = config;
+    server.pokedex = pokedex;
+    server.progress = progress;
+    server.server_sock = server_sock;
+    server.handoff_peer = -1;
+    server.idle_head = server.idle_tail = -1;
+
+    int max_conns = config->max_connections > 0 ? config->max_connections : 1;
+    server.max_conns = max_conns;
+    server.conns = calloc((size_t)max_conns, sizeof(Connection));
+    server.free_slots = malloc(sizeof(int) * (size_t)max_conns);
+    server.poll_owner = malloc(sizeof(int) * (size_t)(max_conns + FIXED_POLL_ENTRIES));
+    server.fds = malloc(sizeof(struct pollfd) * (size_t)(max_conns + FIXED_POLL_ENTRIES));
+    if (!server.conns || !server.free_slots || !server.poll_owner || !server.fds) {
+        printf("Out of memory\n");
+        return 1;
+    }
+
+    for (int i = max_conns - 1; i >= 0; i--) {
+        server.conns[i].sock = -1;
+        server.free_slots[server.free_count++] = i;
+    }
+
+    int handoff_sock = config->handoff_path ? handoff_listen(config->handoff_path) : -1;
+    if (config->handoff_path && handoff_sock < 0) {
+        printf("Warning: could not open handoff socket %s\n", config->handoff_path);
+    }
+
+    #ifndef _WIN32
+    int signal_fd = signal_pipe[0];
+    #else
+    int signal_fd = -1;
+    #endif
+
+    int fixed_fds[FIXED_POLL_ENTRIES] = { server_sock, signal_fd, handoff_sock };
+    for (int k = 0; k < FIXED_POLL_ENTRIES; k++) {
+        server.fds[k].fd = fixed_fds[k];
+        server.fds[k].events = POLLIN;
+        server.fds[k].revents = 0;
+        server.poll_owner[k] = -1;
+    }
+    server.nfds = FIXED_POLL_ENTRIES;
+
+    timer_wheel_init(&server.deadlines, now_ms(), DEADLINE_RESOLUTION_MS);
+    ratelimit_init(&limiter, config->rate_per_sec, config->burst, now_ms());
+
+    if (config->access_log_path && !access_log_start(config->access_log_path, config->log_sample)) {
+        printf("Warning: could not open access log %s\n", config->access_log_path);
+    }
+
+    printf("Server running on http://localhost:%d\n", config->port);
+    printf("Open your browser and go to http://localhost:%d\n\n", config->port);
+    fflush(stdout);
+
+    bool served = false;
+    #ifdef HAVE_IO_URING
+    if (config->io_uring) {
+        served = uring_loop(&server);
+        if (!served) printf("io_uring unavailable, falling back to poll()\n");
+    }
+    #endif
+    if (!served) poll_loop(&server);
+
+    // Everything in flight has been answered: persist before letting go
+    if (!save_user_progress(PROGRESS_FILE, progress)) {
+        printf("Warning: failed to save progress\n");
+    }
+
+    if (server.handoff_peer >= 0) {
+        // Closing the peer tells the replacement the progress file is final
+        closesocket(server.handoff_peer);
+    } else if (config->handoff_path && handoff_sock >= 0) {
+        #ifndef _WIN32
+        unlink(config->handoff_path);
+        #endif
+    }
+
+    if (handoff_sock >= 0) closesocket(handoff_sock);
+    closesocket(server_sock);
+
+    access_log_stop();
+    if (access_log_dropped() > 0) {
+        printf("Access log dropped %llu record(s)\n", access_log_dropped());
+    }
+    printf("Server stopped\n");
+    fflush(stdout);
+
+    for (int i = 0; i < max_conns; i++) {
+        free(server.conns[i].out.data);
+    }
+    free(server.fds);
+    free(server.poll_owner);
+    free(server.free_slots);
+    free(server.conns);
+    return 0;
+}
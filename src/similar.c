@@ -0,0 +1,70 @@
+/**
+ * similar.c - Stat-similarity search
+ * Brute-force k-nearest-neighbour scan over a packed base-stat matrix
+ */
+
+#include <string.h>
+#include "../include/pokemon.h"
+
+/**
+ * Pack the six base stats into per-stat columns so the distance scan
+ * reads contiguous 16-bit lanes. Padding past the last species stays zero
+ */
+void build_stat_index(PokedexData* pokedex) {
+    memset(pokedex->stat_columns, 0, sizeof(pokedex->stat_columns));
+
+    for (int i = 0; i < pokedex->count; i++) {
+        Pokemon* p = &pokedex->pokemon_array[i];
+        pokedex->stat_columns[STAT_HP][i] = (short)p->hp;
+        pokedex->stat_columns[STAT_ATTACK][i] = (short)p->attack;
+        pokedex->stat_columns[STAT_DEFENSE][i] = (short)p->defense;
+        pokedex->stat_columns[STAT_SP_ATTACK][i] = (short)p->sp_attack;
+        pokedex->stat_columns[STAT_SP_DEFENSE][i] = (short)p->sp_defense;
+        pokedex->stat_columns[STAT_SPEED][i] = (short)p->speed;
+    }
+}
+
+/**
+ * Find the k species whose stat vectors are closest (squared Euclidean
+ * distance) to the given one. If type_filter is non-zero, only species
+ * with at least one type in the mask are considered.
+ * Returns the number of results written, or -1 if id is invalid
+ */
+int find_similar(PokedexData* pokedex, int id, int k, unsigned int type_filter,
+                 SimilarResult* results) {
+    if (!search_by_id(pokedex, id)) return -1;
+    if (k > MAX_SIMILAR_RESULTS) k = MAX_SIMILAR_RESULTS;
+    if (k <= 0) return 0;
+
+    int target = id - 1;
+    int distance[POKEMON_COLUMN_STRIDE];
+    memset(distance, 0, sizeof(distance));
+
+    // One pass per stat over contiguous columns, which the compiler vectorizes
+    for (int stat = 0; stat < STAT_COUNT; stat++) {
+        const short* column = pokedex->stat_columns[stat];
+        int q = column[target];
+        for (int s = 0; s < POKEMON_COLUMN_STRIDE; s++) {
+            int d = column[s] - q;
+            distance[s] += d * d;
+        }
+    }
+
+    // Keep the k best in a small sorted array (insertion, k is tiny)
+    int found = 0;
+    for (int s = 0; s < pokedex->count; s++) {
+        if (s == target) continue;
+        if (type_filter && !(pokedex->type_mask[s] & type_filter)) continue;
+        if (found == k && distance[s] >= results[k - 1].distance) continue;
+
+        int pos = found < k ? found++ : k - 1;
+        while (pos > 0 && results[pos - 1].distance > distance[s]) {
+            results[pos] = results[pos - 1];
+            pos--;
+        }
+        results[pos].id = s + 1;
+        results[pos].distance = distance[s];
+    }
+
+    return found;
+}
@@ -0,0 +1,169 @@
+/**
+ * timer_wheel.c - Hierarchical timer wheel
+ * O(1) schedule/cancel for intrusive timers. Level 0 slots are one tick
+ * wide; each higher level covers TIMER_WHEEL_SLOTS times the span of the
+ * one below and is cascaded down as time reaches it
+ */
+
+#include <stddef.h>
+#include "../include/pokemon.h"
+
+#define SLOT_MASK (TIMER_WHEEL_SLOTS - 1)
+
+static void list_init(TimerNode* head) {
+    head->prev = head;
+    head->next = head;
+}
+
+static void list_unlink(TimerNode* node) {
+    node->prev->next = node->next;
+    node->next->prev = node->prev;
+    node->prev = node->next = NULL;
+}
+
+static void list_append(TimerNode* head, TimerNode* node) {
+    node->prev = head->prev;
+    node->next = head;
+    head->prev->next = node;
+    head->prev = node;
+}
+
+/**
+ * Move every node of a slot onto a detached list so callbacks and
+ * re-placement cannot disturb the walk
+ */
+static void list_splice(TimerNode* from, TimerNode* to) {
+    list_init(to);
+    if (from->next == from) return;
+
+    to->next = from->next;
+    to->prev = from->prev;
+    to->next->prev = to;
+    to->prev->next = to;
+    list_init(from);
+}
+
+/**
+ * Put a node in the lowest level whose span reaches its expiry tick
+ */
+static void place(TimerWheel* wheel, TimerNode* node) {
+    unsigned long long tick = node->expires_ms / wheel->resolution_ms;
+    if (tick < wheel->current_tick) tick = wheel->current_tick;
+
+    unsigned long long delta = tick - wheel->current_tick;
+    int level = 0;
+    while (level < TIMER_WHEEL_LEVELS - 1 &&
+           delta >= 1ULL << (TIMER_WHEEL_BITS * (level + 1))) {
+        level++;
+    }
+
+    // Beyond the top level's span: park in the furthest slot and re-place later
+    if (delta >= 1ULL << (TIMER_WHEEL_BITS * TIMER_WHEEL_LEVELS)) {
+        tick = wheel->current_tick + (1ULL << (TIMER_WHEEL_BITS * TIMER_WHEEL_LEVELS)) - 1;
+    }
+
+    size_t slot = (size_t)(tick >> (TIMER_WHEEL_BITS * level)) & SLOT_MASK;
+    list_append(&wheel->slots[level][slot], node);
+}
+
+/**
+ * Initialize an empty wheel whose level 0 slots are resolution_ms wide
+ */
+void timer_wheel_init(TimerWheel* wheel, unsigned long long now_ms, unsigned int resolution_ms) {
+    for (int level = 0; level < TIMER_WHEEL_LEVELS; level++) {
+        for (int i = 0; i < TIMER_WHEEL_SLOTS; i++) {
+            list_init(&wheel->slots[level][i]);
+        }
+    }
+    wheel->resolution_ms = resolution_ms > 0 ? resolution_ms : 1;
+    wheel->current_tick = now_ms / wheel->resolution_ms;
+    wheel->pending = 0;
+}
+
+/**
+ * Schedule (or reschedule) a timer to fire at expires_ms
+ */
+void timer_schedule(TimerWheel* wheel, TimerNode* node, unsigned long long expires_ms) {
+    if (node->next) {
+        list_unlink(node);
+    } else {
+        wheel->pending++;
+    }
+
+    node->expires_ms = expires_ms;
+    place(wheel, node);
+}
+
+/**
+ * Cancel a pending timer (no-op if it is not scheduled)
+ */
+void timer_cancel(TimerWheel* wheel, TimerNode* node) {
+    if (node->next) {
+        list_unlink(node);
+        wheel->pending--;
+    }
+}
+
+/**
+ * Re-place every node of a higher-level slot into the levels below
+ */
+static void cascade(TimerWheel* wheel, int level) {
+    size_t slot = (size_t)(wheel->current_tick >> (TIMER_WHEEL_BITS * level)) & SLOT_MASK;
+    TimerNode detached;
+    list_splice(&wheel->slots[level][slot], &detached);
+
+    while (detached.next != &detached) {
+        TimerNode* node = detached.next;
+        list_unlink(node);
+        place(wheel, node);
+    }
+}
+
+/**
+ * Advance the wheel to now_ms, calling on_expire for every due timer.
+ * Returns the number of timers that fired
+ */
+int timer_wheel_advance(TimerWheel* wheel, unsigned long long now_ms,
+                        void (*on_expire)(TimerNode* node, void* ctx), void* ctx) {
+    unsigned long long target = now_ms / wheel->resolution_ms;
+    int fired = 0;
+
+    // Nothing to expire: jump straight to the present
+    if (wheel->pending == 0) {
+        if (target > wheel->current_tick) wheel->current_tick = target;
+        return 0;
+    }
+
+    while (wheel->current_tick <= target) {
+        // At a period boundary, pull the matching higher-level slots down,
+        // highest first so their nodes can fall through several levels
+        int top = 0;
+        while (top < TIMER_WHEEL_LEVELS - 1 &&
+               (wheel->current_tick & ((1ULL << (TIMER_WHEEL_BITS * (top + 1))) - 1)) == 0) {
+            top++;
+        }
+        for (int level = top; level > 0; level--) {
+            cascade(wheel, level);
+        }
+
+        TimerNode due;
+        list_splice(&wheel->slots[0][wheel->current_tick & SLOT_MASK], &due);
+
+        while (due.next != &due) {
+            TimerNode* node = due.next;
+            list_unlink(node);
+            if (node->expires_ms <= now_ms) {
+                wheel->pending--;
+                on_expire(node, ctx);
+                fired++;
+            } else {
+                place(wheel, node);
+            }
+        }
+
+        if (wheel->current_tick == target) break;
+        wheel->current_tick++;
+    }
+
+    return fired;
+}
@@ -0,0 +1,152 @@
+/**
+ * types.c - Type effectiveness engine
+ * Interns type names to ids and scores matchups from a precomputed chart
+ */
+
+#include <string.h>
+#include <strings.h>
+#include "../include/pokemon.h"
+
+static const char* type_names[TYPE_COUNT] = {
+    "Normal", "Fire", "Water", "Electric", "Grass", "Ice",
+    "Fighting", "Poison", "Ground", "Flying", "Psychic", "Bug",
+    "Rock", "Ghost", "Dragon", "Dark", "Steel", "Fairy"
+};
+
+/**
+ * Attacker (row) vs defender (column), in units of x0.5:
+ * 0 = no effect, 1 = not very effective, 2 = normal, 4 = super effective.
+ * Columns follow the TypeId order of the rows
+ */
+static const unsigned char type_chart[TYPE_COUNT][TYPE_COUNT] = {
+    /* NOR */ { 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 1, 0, 2, 2, 1, 2 },
+    /* FIR */ { 2, 1, 1, 2, 4, 4, 2, 2, 2, 2, 2, 4, 1, 2, 1, 2, 4, 2 },
+    /* WAT */ { 2, 4, 1, 2, 1, 2, 2, 2, 4, 2, 2, 2, 4, 2, 1, 2, 2, 2 },
+    /* ELE */ { 2, 2, 4, 1, 1, 2, 2, 2, 0, 4, 2, 2, 2, 2, 1, 2, 2, 2 },
+    /* GRA */ { 2, 1, 4, 2, 1, 2, 2, 1, 4, 1, 2, 1, 4, 2, 1, 2, 1, 2 },
+    /* ICE */ { 2, 1, 1, 2, 4, 1, 2, 2, 4, 4, 2, 2, 2, 2, 4, 2, 1, 2 },
+    /* FIG */ { 4, 2, 2, 2, 2, 4, 2, 1, 2, 1, 1, 1, 4, 0, 2, 4, 4, 1 },
+    /* POI */ { 2, 2, 2, 2, 4, 2, 2, 1, 1, 2, 2, 2, 1, 1, 2, 2, 0, 4 },
+    /* GRO */ { 2, 4, 2, 4, 1, 2, 2, 4, 2, 0, 2, 1, 4, 2, 2, 2, 4, 2 },
+    /* FLY */ { 2, 2, 2, 1, 4, 2, 4, 2, 2, 2, 2, 4, 1, 2, 2, 2, 1, 2 },
+    /* PSY */ { 2, 2, 2, 2, 2, 2, 4, 4, 2, 2, 1, 2, 2, 2, 2, 0, 1, 2 },
+    /* BUG */ { 2, 1, 2, 2, 4, 2, 1, 1, 2, 1, 4, 2, 2, 1, 2, 4, 1, 1 },
+    /* ROC */ { 2, 4, 2, 2, 2, 4, 1, 2, 1, 4, 2, 4, 2, 2, 2, 2, 1, 2 },
+    /* GHO */ { 0, 2, 2, 2, 2, 2, 2, 2, 2, 2, 4, 2, 2, 4, 2, 1, 2, 2 },
+    /* DRA */ { 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 4, 2, 1, 0 },
+    /* DAR */ { 2, 2, 2, 2, 2, 2, 1, 2, 2, 2, 4, 2, 2, 4, 2, 1, 2, 1 },
+    /* STE */ { 2, 1, 1, 1, 2, 4, 2, 2, 2, 2, 2, 2, 4, 2, 2, 2, 1, 4 },
+    /* FAI */ { 2, 1, 2, 2, 2, 2, 4, 1, 2, 2, 2, 2, 2, 2, 4, 4, 1, 2 },
+};
+
+/**
+ * Intern a type name (case-insensitive). Returns TYPE_NONE if unknown
+ */
+int type_from_name(const char* name) {
+    for (int t = 0; t < TYPE_COUNT; t++) {
+        if (strcasecmp(name, type_names[t]) == 0) return t;
+    }
+    return TYPE_NONE;
+}
+
+/**
+ * Display name for a type id ("" for TYPE_NONE)
+ */
+const char* type_name(int type_id) {
+    if (type_id < 0 || type_id >= TYPE_COUNT) return "";
+    return type_names[type_id];
+}
+
+/**
+ * Multiplier of an attacking type against one or two defending types,
+ * in units of x0.25 (0, 1, 2, 4, 8 or 16). Pass TYPE_NONE as defender2
+ * for single-typed defenders. Returns -1 if a type id is out of range
+ */
+int type_effectiveness(int attacker, int defender1, int defender2) {
+    if (attacker < 0 || attacker >= TYPE_COUNT) return -1;
+    if (defender1 < 0 || defender1 >= TYPE_COUNT) return -1;
+    if (defender2 != TYPE_NONE && (defender2 < 0 || defender2 >= TYPE_COUNT)) return -1;
+
+    int mult = type_chart[attacker][defender1] * 2;
+    if (defender2 != TYPE_NONE) {
+        mult = mult * type_chart[attacker][defender2] / 2;
+    }
+    return mult;
+}
+
+/**
+ * Precompute, for every attacking type, its multiplier against each
+ * species as a contiguous byte column, plus a type bitmask per species.
+ * Padding past the last species stays zero
+ */
+void build_type_index(PokedexData* pokedex) {
+    memset(pokedex->type_effect, 0, sizeof(pokedex->type_effect));
+    memset(pokedex->type_mask, 0, sizeof(pokedex->type_mask));
+    
+    for (int i = 0; i < pokedex->count; i++) {
+        Pokemon* p = &pokedex->pokemon_array[i];
+        pokedex->type_mask[i] = 1u << p->type1_id;
+        if (p->type2_id != TYPE_NONE) {
+            pokedex->type_mask[i] |= 1u << p->type2_id;
+        }
+
+        for (int t = 0; t < TYPE_COUNT; t++) {
+            pokedex->type_effect[t][i] = (unsigned char)type_effectiveness(t, p->type1_id, p->type2_id);
+        }
+    }
+}
+
+/**
+ * Score a team against every species in the dex, assuming each member
+ * attacks with its own types. Returns 1 on success, 0 if an id is invalid
+ */
+int score_team(PokedexData* pokedex, const int* ids, int count, TeamCoverage* out) {
+    unsigned char best[POKEMON_COLUMN_STRIDE];
+    unsigned int attack_types = 0;
+
+    memset(out, 0, sizeof(TeamCoverage));
+    for (int m = 0; m < count; m++) {
+        Pokemon* p = search_by_id(pokedex, ids[m]);
+        if (!p || m >= MAX_TEAM_SIZE) return 0;
+        out->team_ids[m] = p->id;
+        attack_types |= 1u << p->type1_id;
+        if (p->type2_id != TYPE_NONE) attack_types |= 1u << p->type2_id;
+    }
+    out->team_size = count;
+
+    // Offense: best multiplier any team type achieves against each species.
+    // Byte-wise max over fixed-stride columns, which the compiler vectorizes
+    memset(best, 0, sizeof(best));
+    for (int t = 0; t < TYPE_COUNT; t++) {
+        if (!(attack_types & (1u << t))) continue;
+        const unsigned char* column = pokedex->type_effect[t];
+        for (int s = 0; s < POKEMON_COLUMN_STRIDE; s++) {
+            best[s] = column[s] > best[s] ? column[s] : best[s];
+        }
+    }
+
+    for (int s = 0; s < POKEMON_COLUMN_STRIDE; s++) {
+        out->super_effective += best[s] > 4;
+        out->neutral += best[s] == 4;
+        out->resisted += best[s] > 0 && best[s] < 4;
+        out->immune += best[s] == 0;
+    }
+    out->immune -= POKEMON_COLUMN_STRIDE - pokedex->count;   // Padding scores as immune
+
+    // Defense: species carrying any type that hits this member super effectively
+    for (int m = 0; m < count; m++) {
+        int index = out->team_ids[m] - 1;
+        unsigned int threat_types = 0;
+        for (int t = 0; t < TYPE_COUNT; t++) {
+            if (pokedex->type_effect[t][index] > 4) threat_types |= 1u << t;
+        }
+
+        int threatened = 0;
+        for (int s = 0; s < POKEMON_COLUMN_STRIDE; s++) {
+            threatened += (pokedex->type_mask[s] & threat_types) != 0;
+        }
+        out->threatened_by[m] = threatened;
+    }
+
+    return 1;
+}
@@ -0,0 +1,176 @@
+/**
+ * uring.c - Minimal io_uring ring over the raw system calls
+ * Just enough for the event loop: set up and map the rings, hand out
+ * SQEs, submit/wait in one call and walk completions
+ */
+
+#include "../include/pokemon.h"
+
+#ifdef HAVE_IO_URING
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <linux/io_uring.h>
+
+struct IoRing {
+    int fd;
+    unsigned* sq_head;
+    unsigned* sq_tail;
+    unsigned* sq_mask;
+    unsigned* sq_array;
+    unsigned sq_entries;
+    unsigned sq_local_tail;         // SQEs handed out but not yet published
+    struct io_uring_sqe* sqes;
+    unsigned* cq_head;
+    unsigned* cq_tail;
+    unsigned* cq_mask;
+    struct io_uring_cqe* cqes;
+    void* sq_ring;
+    size_t sq_ring_size;
+    void* cq_ring;
+    size_t cq_ring_size;
+    size_t sqes_size;
+};
+
+/**
+ * Create a ring with room for entries submissions
+ * Returns NULL if io_uring is unavailable (old kernel, seccomp, limits)
+ */
+IoRing* uring_create(unsigned entries) {
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+
+    int fd = (int)syscall(__NR_io_uring_setup, entries, &params);
+    if (fd < 0) return NULL;
+
+    IoRing* ring = calloc(1, sizeof(IoRing));
+    if (!ring) {
+        close(fd);
+        return NULL;
+    }
+    ring->fd = fd;
+
+    ring->sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    ring->cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single_mmap && ring->cq_ring_size > ring->sq_ring_size) {
+        ring->sq_ring_size = ring->cq_ring_size;
+    }
+
+    ring->sq_ring = mmap(NULL, ring->sq_ring_size, PROT_READ | PROT_WRITE,
+                         MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    ring->cq_ring = single_mmap ? ring->sq_ring :
+                    mmap(NULL, ring->cq_ring_size, PROT_READ | PROT_WRITE,
+                         MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+    ring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    ring->sqes = mmap(NULL, ring->sqes_size, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+
+    if (ring->sq_ring == MAP_FAILED || ring->cq_ring == MAP_FAILED || ring->sqes == MAP_FAILED) {
+        if (ring->sqes == MAP_FAILED) ring->sqes = NULL;
+        if (ring->cq_ring == MAP_FAILED) ring->cq_ring = NULL;
+        if (ring->sq_ring == MAP_FAILED) ring->sq_ring = NULL;
+        uring_destroy(ring);
+        return NULL;
+    }
+
+    char* sq = ring->sq_ring;
+    ring->sq_head = (unsigned*)(sq + params.sq_off.head);
+    ring->sq_tail = (unsigned*)(sq + params.sq_off.tail);
+    ring->sq_mask = (unsigned*)(sq + params.sq_off.ring_mask);
+    ring->sq_array = (unsigned*)(sq + params.sq_off.array);
+    ring->sq_entries = params.sq_entries;
+    ring->sq_local_tail = *ring->sq_tail;
+
+    char* cq = ring->cq_ring;
+    ring->cq_head = (unsigned*)(cq + params.cq_off.head);
+    ring->cq_tail = (unsigned*)(cq + params.cq_off.tail);
+    ring->cq_mask = (unsigned*)(cq + params.cq_off.ring_mask);
+    ring->cqes = (struct io_uring_cqe*)(cq + params.cq_off.cqes);
+    return ring;
+}
+
+/**
+ * Unmap and close the ring; the kernel cancels anything still in flight
+ */
+void uring_destroy(IoRing* ring) {
+    if (!ring) return;
+    if (ring->sqes) munmap(ring->sqes, ring->sqes_size);
+    if (ring->cq_ring && ring->cq_ring != ring->sq_ring) munmap(ring->cq_ring, ring->cq_ring_size);
+    if (ring->sq_ring) munmap(ring->sq_ring, ring->sq_ring_size);
+    close(ring->fd);
+    free(ring);
+}
+
+/**
+ * Submit everything queued so far and wait for at least wait_nr completions
+ * Returns the number submitted, or -errno
+ */
+int uring_submit(IoRing* ring, unsigned wait_nr) {
+    unsigned tail = *ring->sq_tail;
+    unsigned pending = ring->sq_local_tail - tail;
+    __atomic_store_n(ring->sq_tail, ring->sq_local_tail, __ATOMIC_RELEASE);
+
+    unsigned flags = wait_nr > 0 ? IORING_ENTER_GETEVENTS : 0;
+    int result;
+    do {
+        result = (int)syscall(__NR_io_uring_enter, ring->fd, pending, wait_nr, flags, NULL, 0);
+    } while (result < 0 && errno == EINTR);
+    return result < 0 ? -errno : result;
+}
+
+/**
+ * Next free SQE, zeroed. A full queue is flushed to the kernel first
+ */
+struct io_uring_sqe* uring_get_sqe(IoRing* ring) {
+    unsigned head = __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE);
+    if (ring->sq_local_tail - head >= ring->sq_entries) {
+        if (uring_submit(ring, 0) < 0) return NULL;
+        head = __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE);
+        if (ring->sq_local_tail - head >= ring->sq_entries) return NULL;
+    }
+
+    unsigned index = ring->sq_local_tail & *ring->sq_mask;
+    ring->sq_array[index] = index;
+    ring->sq_local_tail++;
+
+    struct io_uring_sqe* sqe = &ring->sqes[index];
+    memset(sqe, 0, sizeof(*sqe));
+    return sqe;
+}
+
+/**
+ * Oldest unconsumed completion, or NULL when the queue is empty
+ */
+struct io_uring_cqe* uring_peek_cqe(IoRing* ring) {
+    unsigned head = *ring->cq_head;
+    if (head == __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE)) return NULL;
+    return &ring->cqes[head & *ring->cq_mask];
+}
+
+void uring_cqe_seen(IoRing* ring) {
+    __atomic_store_n(ring->cq_head, *ring->cq_head + 1, __ATOMIC_RELEASE);
+}
+
+/**
+ * Register fixed buffers (IORING_OP_READ_FIXED / WRITE_FIXED targets)
+ * Returns 1 on success, 0 on failure
+ */
+int uring_register_buffers(IoRing* ring, const struct iovec* buffers, unsigned count) {
+    return syscall(__NR_io_uring_register, ring->fd, IORING_REGISTER_BUFFERS, buffers, count) == 0;
+}
+
+/**
+ * Register the fixed file table; -1 entries are empty slots
+ * Returns 1 on success, 0 on failure
+ */
+int uring_register_files(IoRing* ring, const int* fds, unsigned count) {
+    return syscall(__NR_io_uring_register, ring->fd, IORING_REGISTER_FILES, fds, count) == 0;
+}
+
+#endif